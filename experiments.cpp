@@ -15,6 +15,7 @@
 #include <ctime>
 #include <cstdlib>
 #include <dirent.h>
+#include <algorithm>
 // #include <bits/stdc++.h>
 
 #include "old_funcs.hpp"
@@ -217,9 +218,9 @@ unordered_set<int> preprocess(string inputFolder, string inputFile, string outpu
     unordered_set<int> assignment = simplify(old_vars, formula, false, print);
 
     // Renumber if needed, updating number of vars
-    unordered_map<int, int> assignments;
+    vector<int> assignments, new_to_old;
     if(renumber) {
-        vars = renumberFormula(formula, assignments);
+        vars = renumberFormula(formula, assignments, new_to_old);
     }
 
     // Output to file
@@ -494,10 +495,15 @@ int main() {
     // Partition p(c.vars, c.formula);
     // p.debug = true;
 
+    // Parallel multi-start partitioning (d = 0 for a bisection, d > 0 to also remove d vars)
+    // set<int> removed;
+    // vector<set<int>> parts = p.multiStartPartition(64, removed, 0, 0, 1, "tmp_restart_curve.csv");
+
     // Clause Partitioning
     // ClausePartition clause_part(c.vars, c.formula);
     // string heur = "round-robin";
     // heur = "random";
+    // heur = "multilevel";
 
     // clause_part.debug = true;
     // int trials = 10;
@@ -507,6 +513,7 @@ int main() {
     //     clause_part.createSubarrays(1024, heur);
     //     unordered_map<int, set<int>> groups_activated;
     //     groups_activated = clause_part.checkGroupings(0b11111);
+    //     // or many masks at once: clause_part.checkGroupingsMasks({0b1111, 0b11111, 0b111111});
 
     //     for(pair<int, set<int>> p : groups_activated) {
     //         totals[p.first] += p.second.size();
@@ -519,19 +526,47 @@ int main() {
     int num_groups = 32;
     int num_subarrays = c.clauses;
     unordered_map<int, int> mappings = findGroupsMappingHelper(c.clauses, randomize, num_subarrays, num_groups);
+    // unordered_map<int, int> mappings = findGroupsMappingMultilevel(c.vars, c.formula, num_subarrays, num_groups);
     unordered_map<int, set<int>> results = runGroupsExperiment(c.vars, c.formula, mappings);
     printGroupsResults(results, num_groups); */
 
+    // Randomized groupings over many trials (same seed and trial always give the same mapping)
+    // vector<vector<int>> trial_mappings = findGroupsMappings(c.clauses, 100, true, num_subarrays, num_groups, 42);
+
+    // Many configurations at once (CSV can be plotted with plot_group_histograms in visualizer.py)
+    // vector<GroupsConfig> configs = {GroupsConfig(1024, 32), GroupsConfig(1024, 32, true, 10), 
+    //                                 GroupsConfig(c.clauses, 32), GroupsConfig(c.clauses, 32, true, 10)};
+    // runGroupsExperimentBatch(c.vars, c.formula, configs, "group_histograms.csv");
+
     // Divide and Conquer
     // int k = 3;
-    // string heur = "mom";
+    // string heur = "mom"; // or "lookahead"
     // cout << "Heur: " << heur << endl;
     // divideAndConquerHeur(c, k, heur, false);
+    // or keep the cubes (decisions to use as assumptions) instead of printing them
+    // CubeGenerator generator(c.vars, c.formula);
+    // vector<Cube> cubes = generator.generate(k, heur);
+    // and solve them in parallel with minisat
+    // CubeSolver cube_solver(c.vars, c.formula);
+    // vector<int> model;
+    // cube_solver.solveBaseline(model);
+    // bool sat = cube_solver.solveCubes(cubes, model);
+    // cout << (sat ? "SAT" : "UNSAT") << endl;
+    // cube_solver.printStats();
+    // Remove backbone literals (true in every model) first, so fewer vars are left to split on
+    // BackboneExtractor backbone(c.vars, c.formula);
+    // backbone.extract();
+    // backbone.printStats();
+    // vector<vector<int>> reduced = backbone.simplifiedFormula();
+    // CubeGenerator reduced_generator(c.vars, reduced);
+    // vector<Cube> reduced_cubes = reduced_generator.generate(k, heur);
 
     // Solve
     // unordered_set<int> s;
     // int count = 0;
     // solve(c.formula, s, c.vars, "mom", true, true, count);
+    // or the original version, which scans the whole formula every step (to compare against)
+    // solveOld(c.formula, s, c.vars, "mom", true, true, count);
 
 
     // Contiguous Partition (by max vars)
@@ -540,6 +575,10 @@ int main() {
     // int groups = cont_part.createPartitionsBySize(max_vars);
     // cont_part.evaluateGroupings();
 
+    // Streaming version (formula is never stored), writes group boundaries to a file
+    // vector<int> histogram;
+    // streamContiguousPartition(path+file, max_vars, "tmp_groups.txt", histogram, true);
+
     // findAllMeanAndSdClauses(c.vars, c.formula);
 
     // Before running these, make sure ../minisat/output_assignments has only assignments for this problem
@@ -547,6 +586,45 @@ int main() {
     // vector<string> files = minisat_experiment_run(path, file);
     // cout << "Comparing heuristic lists..." << endl;
     // minisat_experiment_analyze(files);
+    // or stream the snapshots once (Kendall tau and top-k overlap for every snapshot)
+    // Circuit c(path+file);
+    // HeurListDrift drift(c.vars, c.formula, 100);
+    // drift.run("../minisat/output_assignments/", "tmp_heur_drift.csv");
+    // Same with a binary snapshot log (minisat -snapshot-log=trace.bin -snapshot-every=1000 <cnf>), or convert an old folder
+    // writeSnapshotLog("../minisat/output_assignments/", "tmp_trace.bin", c.vars);
+    // drift.run("tmp_trace.bin", "tmp_heur_drift.csv");
+
+    // Place clauses using the solver trace (hot vars touch fewer subarrays), compared with round-robin
+    // Circuit c(path+file);
+    // runTracePlacementExperiment(c.vars, c.formula, "../minisat/output_assignments/", 1024, 32);
+
+    // Reorder clauses and vars to shrink spans before mapping
+    // Circuit c(path+file);
+    // ReorderFormula reorder(c.vars, c.formula);
+    // reorder.reorder("reverse-cuthill-mckee"); // or "cuthill-mckee", "spectral", "force"
+    // reorder.writeReordered("tmp_reordered.txt", "This is a reordered version of " + path + file + ".");
+
+    // Compare throughput of formula writers (text vs. buffered text vs. binary)
+    // Circuit c(path+file);
+    // benchmarkFormulaWriters(c.formula, c.vars, "tmp_writer_bench.txt", 3);
+
+    // Split into independent components, then solve and map each one in parallel
+    // Circuit c(path+file);
+    // ComponentDecomposition comp(c.vars, c.formula);
+    // comp.debug = true;
+    // comp.decompose(true);
+    // vector<int> model;
+    // cout << (comp.solveComponents(model, "jeroslow-wang") ? "SAT" : "UNSAT") << endl;
+    // cout << comp.mapComponents(0.5, "prune") << " / " << comp.components.size() << " components mapped" << endl;
+
+    // Random assignment metrics, 256 assignments per pass (bit-sliced) instead of one
+    // Circuit c(path+file);
+    // double unsatisfied_avg, solutions_percent;
+    // unsatisfiedAndSolutionsMetricBits(c.vars, c.formula, 10000000, unsatisfied_avg, solutions_percent);
+    // cout << "Unsatisfied avg: " << unsatisfied_avg << ", Solutions: " << solutions_percent << "%" << endl;
+
+    // Occurrence, balance and span metrics for every formula in a folder (one pass per formula, one CSV row each)
+    // runFormulaMetrics(SAT2017_PATH, "tmp_formula_metrics.csv");
 
     for(pair<int, string> p : SAT2017_FILES) {
         Circuit c(SAT2017_PATH + p.second);
@@ -21,6 +21,18 @@
 #include <ctime>
 #include <cstdlib>
 #include <climits>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "minisat/core/Solver.h"
 
 #include "old_funcs.hpp"
 #include "funcs.hpp"
@@ -450,70 +462,74 @@ unordered_set<int> simplify(int vars, vector<vector<int>>& formula, bool method1
  * - modifies formula in place
 */
 int renumberFormula(vector<vector<int>>& formula) {
-    // Maintain map from old variable number to new variable number
-    unordered_map<int, int> m;
-
-    // Assign next number for each new variable seen
-    int curr_num = 1;
-    for(int c = 0; c < formula.size(); ++c) {
-        for(int i = 0; i < formula[c].size(); ++i) {
-            int literal = formula[c][i];
-            int var = abs(literal);
+    vector<int> old_to_new, new_to_old;
+    return renumberFormula(formula, old_to_new, new_to_old);
+}
 
-            if(m.find(var) == m.end()) {
-                // Make pairing
-                m[var] = curr_num;
-                ++curr_num;
-            }
+/**
+ * Given a simplified SAT formula, renumbers the variables so that there
+ * are no gaps in the numbering
+ * 
+ * Params:
+ * - formula: the SAT formula
+ * - m: will be returned, map from old number to new number
+ * 
+ * Returns:
+ * - int: number of vars when simplified
+ * - modifies formula in place
+*/
+int renumberFormula(vector<vector<int>>& formula, unordered_map<int, int>& m) {
+    vector<int> old_to_new, new_to_old;
+    int new_vars = renumberFormula(formula, old_to_new, new_to_old);
 
-            // Update formula
-            if(literal > 0) {
-                formula[c][i] = m[var];
-            } else {
-                formula[c][i] = -1 * m[var];
-            }
-        }
+    // Copy dense mapping into the map
+    for(int v = 1; v <= new_vars; ++v) {
+        m[new_to_old[v]] = v;
     }
 
-    // Return number of vars used
-    return curr_num - 1;
+    return new_vars;
 }
 
 /**
  * Given a simplified SAT formula, renumbers the variables so that there
- * are no gaps in the numbering
+ * are no gaps in the numbering. New numbers are handed out in order of first
+ * occurrence, using dense arrays instead of a hash map so every literal is one
+ * array lookup.
  * 
  * Params:
  * - formula: the SAT formula
- * - m: will be returned, map from old number to new number
+ * - old_to_new: will be returned, old_to_new[old var] is the new var (0 if the var doesn't appear)
+ * - new_to_old: will be returned, new_to_old[new var] is the old var (used to reconstruct models)
  * 
  * Returns:
  * - int: number of vars when simplified
  * - modifies formula in place
 */
-int renumberFormula(vector<vector<int>>& formula, unordered_map<int, int>& m) {
-    // Maintain map from old variable number to new variable number
-    // unordered_map<int, int> m;
+int renumberFormula(vector<vector<int>>& formula, vector<int>& old_to_new, vector<int>& new_to_old) {
+    // Find largest var number to size the remap
+    int max_var = 0;
+    for(const vector<int>& clause : formula) {
+        for(int lit : clause) max_var = max(max_var, abs(lit));
+    }
+
+    old_to_new.assign(max_var + 1, 0);
+    new_to_old.assign(1, 0);
+    new_to_old.reserve(max_var + 1);
 
-    // Assign next number for each new variable seen
+    // Assign next number for each new variable seen, and update formula in the same pass
     int curr_num = 1;
-    for(int c = 0; c < formula.size(); ++c) {
-        for(int i = 0; i < formula[c].size(); ++i) {
-            int literal = formula[c][i];
-            int var = abs(literal);
+    for(vector<int>& clause : formula) {
+        for(int& lit : clause) {
+            int var = abs(lit);
 
-            if(m.find(var) == m.end()) {
+            if(old_to_new[var] == 0) {
                 // Make pairing
-                m[var] = curr_num;
+                old_to_new[var] = curr_num;
+                new_to_old.push_back(var);
                 ++curr_num;
             }
 
-            // Update formula
-            if(literal > 0) {
-                formula[c][i] = m[var];
-            } else {
-                formula[c][i] = -1 * m[var];
-            }
+            lit = (lit > 0) ? old_to_new[var] : -old_to_new[var];
         }
     }
 
@@ -522,22 +538,136 @@ int renumberFormula(vector<vector<int>>& formula, unordered_map<int, int>& m) {
 }
 
 
+/**
+ * Builds the clause occurrence index of a formula (CSR format): the clauses (0-indexed) of key k are
+ * list[start[k]] .. list[start[k+1]-1], in increasing order. Keys are vars, or literals numbered 2|l| + (l < 0)
+ * 
+ * Params:
+ * - const vector<vector<int>>& formula: the SAT formula (every var must be <= vars)
+ * - int vars: the number of variables
+ * - bool by_literal: if true, keys are literals (2*(vars+1) keys), else vars (vars+1 keys)
+ * - vector<int>& start: returns the start of each key's clauses (size keys+1)
+ * - vector<int>& list: returns the clauses of every key
+ * - bool unique: if true, a clause is listed once per key even if the key repeats in it
+*/
+void buildOccurrenceIndex(const vector<vector<int>>& formula, int vars, bool by_literal, vector<int>& start, vector<int>& list, bool unique) {
+    int keys = by_literal ? 2*(vars+1) : vars+1;
+    auto key = [by_literal](int lit) { return by_literal ? 2*abs(lit) + (lit < 0) : abs(lit); };
+
+    // Last clause each key was counted in (only needed to skip repeats)
+    vector<int> seen(unique ? keys : 0, -1);
+
+    start.assign(keys+1, 0);
+    for(int c = 0; c < formula.size(); ++c) {
+        for(int lit : formula[c]) {
+            int k = key(lit);
+            if(unique) {
+                if(seen[k] == c) continue;
+                seen[k] = c;
+            }
+            ++start[k+1];
+        }
+    }
+    for(int k = 0; k < keys; ++k) start[k+1] += start[k];
+
+    list.resize(start[keys]);
+    vector<int> pos(start.begin(), start.end()-1);
+    if(unique) fill(seen.begin(), seen.end(), -1);
+    for(int c = 0; c < formula.size(); ++c) {
+        for(int lit : formula[c]) {
+            int k = key(lit);
+            if(unique) {
+                if(seen[k] == c) continue;
+                seen[k] = c;
+            }
+            list[pos[k]++] = c;
+        }
+    }
+}
+
+
 /**
  * Given a SAT formula, saves it to a file
+ * Uses CNFWriter, so integers are formatted by hand into a large buffer that is flushed in big chunks
  * 
  * Params:
  * - formula: the SAT formula
  * - vars: the number of variables
- * - assignments: any mappings to write
+ * - assignments: any mappings to write, assignments[old var] = new var (0 if removed)
  * - old_vars: number of variables there used to be (or -1)
  * - old_clauses: number of clauses there used to be
  * - outputFilename
  * - description: added to top of file as a comment (default - empty)
+ * - binary: if true, writes the binary cached format instead (see writeFormulaToBinaryFile()),
+ *      which skips the description and mappings (default - false)
  * 
  * Returns:
  * - creates file
 */
-void writeFormulaToFile(vector<vector<int>>& formula, int vars, unordered_map<int, int> assignments, int old_vars, int old_clauses, string outputFilename, string description) {
+void writeFormulaToFile(vector<vector<int>>& formula, int vars, const vector<int>& assignments, int old_vars, int old_clauses, const string& outputFilename, const string& description, bool binary) {
+    if(binary) {
+        writeFormulaToBinaryFile(formula, vars, outputFilename);
+        return;
+    }
+
+    // Create outputfile
+    CNFWriter writer(outputFilename);
+    if(!writer.isOpen()) return;
+
+    // Add description
+    if(description.size()) {
+        writer.writeString("c ");
+        writer.writeString(description);
+        writer.writeChar('\n');
+    }
+
+    // Write num vars, num clauses
+    if(old_vars > 0) {
+        writer.writeString("c Before: p cnf ");
+        writer.writeInt(old_vars);
+        writer.writeChar(' ');
+        writer.writeInt(old_clauses);
+        writer.writeString("\nc After: p cnf ");
+        writer.writeInt(vars);
+        writer.writeChar(' ');
+        writer.writeInt(formula.size());
+        writer.writeChar('\n');
+    }
+
+    if(assignments.size()) {
+        writer.writeString("c Mappings from old var number to new var number (format is \"old:new\")\n");
+        for(int i = 1; i < assignments.size(); ++i) {
+            if(assignments[i] == 0) continue;
+            writer.writeString("c\t");
+            writer.writeInt(i);
+            writer.writeString(": ");
+            writer.writeInt(assignments[i]);
+            writer.writeChar('\n');
+        }
+    }
+
+    // Write first line (num vars, num clauses)
+    writer.writeString("p cnf ");
+    writer.writeInt(vars);
+    writer.writeChar(' ');
+    writer.writeInt(formula.size());
+    writer.writeChar('\n');
+
+    // Write lines
+    for(const vector<int>& c : formula) {
+        for(int n : c) {
+            writer.writeInt(n);
+            writer.writeChar(' ');
+        }
+        writer.writeString("0\n");
+    }
+}
+
+/**
+ * Original version of writeFormulaToFile(), writes clause by clause through ofstream
+ * Kept to compare throughput against (see benchmarkFormulaWriters())
+*/
+void writeFormulaToFileOld(vector<vector<int>>& formula, int vars, const vector<int>& assignments, int old_vars, int old_clauses, string outputFilename, string description) {
     // Create outputfile
     ofstream myfile(outputFilename);
 
@@ -554,7 +684,8 @@ void writeFormulaToFile(vector<vector<int>>& formula, int vars, unordered_map<in
 
     if(assignments.size()) {
         myfile << "c Mappings from old var number to new var number (format is \"old:new\")" << endl;
-        for(int i = 1; i <= assignments.size(); ++i) {
+        for(int i = 1; i < assignments.size(); ++i) {
+            if(assignments[i] == 0) continue;
             myfile << "c\t" << i << ": " << assignments[i] << endl;
         }
     }
@@ -571,6 +702,373 @@ void writeFormulaToFile(vector<vector<int>>& formula, int vars, unordered_map<in
     }
 }
 
+/**
+ * Saves a SAT formula in the binary cached format
+ * 
+ * Format (all little-endian, as written by the machine):
+ * - 4 bytes: magic "SATB"
+ * - int32: format version (1)
+ * - int32: number of vars
+ * - int32: number of clauses
+ * - int64: total number of literals
+ * - int32 x clauses: size of each clause
+ * - int32 x literals: all literals, clause after clause (no 0 terminators)
+ * 
+ * Params:
+ * - formula: the SAT formula
+ * - vars: the number of variables
+ * - outputFilename
+ * 
+ * Returns:
+ * - creates file
+*/
+void writeFormulaToBinaryFile(vector<vector<int>>& formula, int vars, const string& outputFilename) {
+    CNFWriter writer(outputFilename);
+    if(!writer.isOpen()) return;
+
+    int32_t version = 1;
+    int32_t num_vars = vars;
+    int32_t num_clauses = formula.size();
+    int64_t total_lits = 0;
+    for(const vector<int>& c : formula) total_lits += c.size();
+
+    writer.writeRaw("SATB", 4);
+    writer.writeRaw(&version, sizeof(version));
+    writer.writeRaw(&num_vars, sizeof(num_vars));
+    writer.writeRaw(&num_clauses, sizeof(num_clauses));
+    writer.writeRaw(&total_lits, sizeof(total_lits));
+
+    // Clause sizes
+    for(const vector<int>& c : formula) {
+        int32_t size = c.size();
+        writer.writeRaw(&size, sizeof(size));
+    }
+
+    // Literals
+    for(const vector<int>& c : formula) {
+        writer.writeRaw(c.data(), c.size() * sizeof(int));
+    }
+}
+
+/**
+ * Parses a formula saved with writeFormulaToBinaryFile()
+ * 
+ * Params:
+ * - filename
+ * - formula: filled in with the clauses
+ * - v: set to number of vars
+ * - c: set to number of clauses
+ * 
+ * Returns:
+ * - bool: false if the file couldn't be read
+*/
+bool parseBinaryFormula(const string& filename, vector<vector<int>>& formula, int& v, int& c) {
+    FILE* file = fopen(filename.c_str(), "rb");
+    if(file == nullptr) {
+        cerr << "Error opening file: " << filename << endl;
+        return false;
+    }
+
+    char magic[4];
+    int32_t version = 0, num_vars = 0, num_clauses = 0;
+    int64_t total_lits = 0;
+    bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "SATB", 4) == 0;
+    ok = ok && fread(&version, sizeof(version), 1, file) == 1 && version == 1;
+    ok = ok && fread(&num_vars, sizeof(num_vars), 1, file) == 1;
+    ok = ok && fread(&num_clauses, sizeof(num_clauses), 1, file) == 1;
+    ok = ok && fread(&total_lits, sizeof(total_lits), 1, file) == 1;
+
+    // The counts must match the file size before anything is allocated
+    struct stat sb;
+    ok = ok && fstat(fileno(file), &sb) == 0;
+    ok = ok && num_vars >= 0 && num_clauses >= 0 && total_lits >= 0;
+    ok = ok && total_lits <= sb.st_size / (int64_t)sizeof(int32_t);
+    ok = ok && 24 + (num_clauses + total_lits) * (int64_t)sizeof(int32_t) == (int64_t)sb.st_size;
+
+    vector<int32_t> sizes;
+    vector<int32_t> lits;
+    if(ok) {
+        sizes.resize(num_clauses);
+        lits.resize(total_lits);
+        ok = fread(sizes.data(), sizeof(int32_t), num_clauses, file) == (size_t)num_clauses;
+        ok = ok && fread(lits.data(), sizeof(int32_t), total_lits, file) == (size_t)total_lits;
+    }
+    fclose(file);
+
+    // Clause sizes must add up to the number of literals
+    int64_t sum = 0;
+    for(int i = 0; ok && i < sizes.size(); ++i) {
+        ok = sizes[i] >= 0;
+        sum += sizes[i];
+    }
+    ok = ok && sum == total_lits;
+
+    if(!ok) {
+        cerr << "Error: " << filename << " is not a valid binary formula file." << endl;
+        return false;
+    }
+
+    // Split flat literal array into clauses
+    formula.clear();
+    formula.reserve(num_clauses);
+    int64_t pos = 0;
+    for(int32_t size : sizes) {
+        formula.emplace_back(lits.begin() + pos, lits.begin() + pos + size);
+        pos += size;
+    }
+
+    v = num_vars;
+    c = num_clauses;
+    return true;
+}
+
+/**
+ * Measures throughput of the formula writers on a given formula, printing MB/s for each:
+ * - writeFormulaToFileOld() (ofstream)
+ * - writeFormulaToFile() (buffered text)
+ * - writeFormulaToFile() with binary = true
+ * 
+ * Params:
+ * - formula: the SAT formula
+ * - vars: the number of variables
+ * - outputFilename: scratch file to write to (overwritten, then removed)
+ * - trials: number of times each writer is run (best time is reported)
+*/
+void benchmarkFormulaWriters(vector<vector<int>>& formula, int vars, const string& outputFilename, int trials) {
+    vector<int> no_mappings;
+    vector<string> names = {"ofstream (old)", "buffered text", "buffered binary"};
+
+    cout << "Clauses: " << formula.size() << endl;
+    for(int w = 0; w < names.size(); ++w) {
+        double best_seconds = INT_MAX;
+        long long bytes = 0;
+
+        for(int t = 0; t < trials; ++t) {
+            auto start = chrono::high_resolution_clock::now();
+            if(w == 0) writeFormulaToFileOld(formula, vars, no_mappings, -1, -1, outputFilename);
+            else writeFormulaToFile(formula, vars, no_mappings, -1, -1, outputFilename, "", w == 2);
+            auto end = chrono::high_resolution_clock::now();
+
+            best_seconds = min(best_seconds, chrono::duration<double>(end - start).count());
+
+            struct stat sb;
+            if(stat(outputFilename.c_str(), &sb) == 0) bytes = sb.st_size;
+        }
+
+        double mb = bytes / (1024.0 * 1024.0);
+        cout << names[w] << ": " << fixed << setprecision(2) << mb << " MB in " << best_seconds * 1000 << " ms";
+        cout << "  (" << mb / best_seconds << " MB/s, " << formula.size() / best_seconds / 1e6 << " M clauses/s)" << endl;
+        cout.unsetf(ios::fixed);
+    }
+
+    remove(outputFilename.c_str());
+}
+
+
+// CNFWriter constructor
+CNFWriter::CNFWriter(const string& filename, size_t buffer_size) {
+    name = filename;
+    file = fopen(filename.c_str(), "wb");
+    if(file == nullptr) {
+        cerr << "Error opening file: " << filename << endl;
+    }
+    buffer.resize(max(buffer_size, (size_t)64));
+    pos = 0;
+    failed = false;
+}
+
+// CNFWriter destructor
+CNFWriter::~CNFWriter() {
+    flush();
+    if(file != nullptr && fclose(file) != 0 && !failed) {
+        cerr << "Error writing file: " << name << endl;
+    }
+}
+
+// Writes the buffer to the file
+void CNFWriter::flush() {
+    if(file != nullptr && pos > 0) {
+        writeFile(buffer.data(), pos);
+    }
+    pos = 0;
+}
+
+// Writes bytes straight to the file, reporting the first failed write (ex: disk full)
+void CNFWriter::writeFile(const void* data, size_t bytes) {
+    if(failed) return;
+    if(fwrite(data, 1, bytes, file) != bytes) {
+        cerr << "Error writing file: " << name << endl;
+        failed = true;
+    }
+}
+
+// Writes a single character
+void CNFWriter::writeChar(char c) {
+    if(pos == buffer.size()) flush();
+    buffer[pos++] = c;
+}
+
+// Writes an integer in decimal (two digits at a time)
+void CNFWriter::writeInt(int n) {
+    static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // Longest int is 11 characters ("-2147483648")
+    if(pos + 11 > buffer.size()) flush();
+
+    unsigned int u = n;
+    if(n < 0) {
+        buffer[pos++] = '-';
+        u = 0u - u;
+    }
+
+    // Fill digits backwards into a scratch array
+    char tmp[10];
+    int i = 10;
+    while(u >= 100) {
+        unsigned int r = (u % 100) * 2;
+        u /= 100;
+        tmp[--i] = digit_pairs[r + 1];
+        tmp[--i] = digit_pairs[r];
+    }
+    if(u >= 10) {
+        tmp[--i] = digit_pairs[u * 2 + 1];
+        tmp[--i] = digit_pairs[u * 2];
+    } else {
+        tmp[--i] = '0' + u;
+    }
+
+    memcpy(&buffer[pos], tmp + i, 10 - i);
+    pos += 10 - i;
+}
+
+// Writes a string
+void CNFWriter::writeString(const string& s) {
+    writeRaw(s.data(), s.size());
+}
+
+// Writes raw bytes (large writes skip the buffer)
+void CNFWriter::writeRaw(const void* data, size_t bytes) {
+    if(pos + bytes > buffer.size()) {
+        flush();
+        if(bytes > buffer.size()) {
+            if(file != nullptr) writeFile(data, bytes);
+            return;
+        }
+    }
+    memcpy(&buffer[pos], data, bytes);
+    pos += bytes;
+}
+
+
+// CNFReader constructor
+CNFReader::CNFReader(const string& filename, size_t buffer_size) {
+    file = fopen(filename.c_str(), "rb");
+    if(file == nullptr) {
+        cerr << "Error opening file: " << filename << endl;
+    }
+    buffer.resize(max(buffer_size, (size_t)64));
+    pos = 0;
+    len = 0;
+    done = (file == nullptr);
+    malformed = false;
+    clauses_read = 0;
+    vars = 0;
+    clauses = 0;
+}
+
+// CNFReader destructor
+CNFReader::~CNFReader() {
+    if(file != nullptr) fclose(file);
+}
+
+// Returns the next character (-1 at end of file)
+int CNFReader::nextChar() {
+    if(pos == len) {
+        if(file == nullptr) return -1;
+        len = fread(buffer.data(), 1, buffer.size(), file);
+        pos = 0;
+        if(len == 0) return -1;
+    }
+    return (unsigned char)buffer[pos++];
+}
+
+// Skips the rest of the current line
+void CNFReader::skipLine() {
+    int ch;
+    do {
+        ch = nextChar();
+    } while(ch != '\n' && ch != -1);
+}
+
+/**
+ * Reads the next clause, without the ending 0 (a lone 0 is an empty clause, so the formula is UNSAT)
+ * Comment lines are skipped, and the "p cnf" line sets vars and clauses
+ * Anything else that isn't a literal sets malformed and stops the reading
+ * 
+ * Params:
+ * - vector<int>& clause: returns the clause
+ * 
+ * Returns:
+ * - bool: false once there are no more clauses (check malformed to tell an error from the end of file)
+*/
+bool CNFReader::nextClause(vector<int>& clause) {
+    clause.clear();
+    while(!done) {
+        int ch = nextChar();
+        if(ch == -1 || ch == '%') {
+            done = true;
+            break;
+        }
+        if(ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') continue;
+
+        // Comment
+        if(ch == 'c') {
+            skipLine();
+            continue;
+        }
+
+        // Header: "p cnf vars clauses"
+        if(ch == 'p') {
+            string line;
+            for(ch = nextChar(); ch != '\n' && ch != -1; ch = nextChar()) line += (char)ch;
+            stringstream header(line);
+            string format;
+            header >> format >> vars >> clauses;
+            continue;
+        }
+
+        // Literal
+        bool negative = (ch == '-');
+        if(negative) ch = nextChar();
+        int lit = 0, digits = 0;
+        while(ch >= '0' && ch <= '9') {
+            lit = lit*10 + (ch - '0');
+            ch = nextChar();
+            ++digits;
+        }
+        if(digits == 0 || (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r' && ch != -1)) {
+            cerr << "ERROR: malformed literal in CNF file (clause " << clauses_read + 1 << ")" << endl;
+            malformed = true;
+            done = true;
+            clause.clear();
+            return false;
+        }
+        if(ch == -1) done = true;
+
+        if(lit == 0) {
+            ++clauses_read;
+            return true;
+        }
+        clause.push_back(negative ? -lit : lit);
+    }
+
+    // Last clause might not end in 0
+    return clause.size() > 0;
+}
+
 
 /**
  * Given a SAT formula and two variables, checks if the pair can be implemented
@@ -2566,22 +3064,94 @@ map<int, pair<int, int>> Architecture::createClauseSpans() {
 
 /**
  * Creates graph from a SAT formula
+ * The graph is built directly into CSR form (neighbors deduplicated with a marker array),
+ * then copied once into edges
 */
 void Partition::createGraph() {
-    // Iterate through each clause to create nodes and edges
-    for(vector<int> c : formula) {
-        for(int i = 0; i < c.size(); ++i) {
-            for(int j = 0; j < c.size(); ++j) {
-                if(i == j) continue;
+    // Clauses of each var (CSR)
+    vector<int> var_start, var_clauses;
+    buildOccurrenceIndex(formula, vars, false, var_start, var_clauses);
+
+    // Neighbors of each var are the other vars in its clauses
+    vector<int> marker(vars+1, 0);
+    adj_start.assign(vars+2, 0);
+    adj.clear();
+    max_degree = 0;
+    for(int v = 1; v <= vars; ++v) {
+        adj_start[v] = adj.size();
+        marker[v] = v;
+        for(int i = var_start[v]; i < var_start[v+1]; ++i) {
+            for(int lit : formula[var_clauses[i]]) {
+                int u = abs(lit);
+                if(marker[u] == v) continue;
+                marker[u] = v;
+                adj.push_back(u);
+            }
+        }
+        sort(adj.begin() + adj_start[v], adj.end());
+        max_degree = max(max_degree, (int)adj.size() - adj_start[v]);
+    }
+    adj_start[vars+1] = adj.size();
 
-                // Create edge
-                int v1 = abs(c[i]), v2 = abs(c[j]);
+    // Map form, for the older functions
+    for(int v = 1; v <= vars; ++v) {
+        if(adj_start[v] == adj_start[v+1]) continue;
+        set<int>& n = edges[v];
+        for(int i = adj_start[v]; i < adj_start[v+1]; ++i) n.insert(n.end(), adj[i]);
+    }
 
-                edges[v1].insert(v2);
-                edges[v2].insert(v1);
-            }
+    visited_epoch.assign(vars+1, 0);
+    bfs_depth.assign(vars+1, 0);
+    frontier.assign(vars, 0);
+    epoch = 0;
+}
+
+
+/**
+ * Starts a new BFS (all nodes become unvisited without clearing anything)
+ * 
+ * Returns:
+ * - int: the new epoch
+*/
+int Partition::newEpoch() {
+    if(++epoch == INT_MAX) {
+        fill(visited_epoch.begin(), visited_epoch.end(), 0);
+        epoch = 1;
+    }
+    return epoch;
+}
+
+/**
+ * BFS from start up to the given depth, on the CSR graph. Nodes already visited in the
+ * current epoch are skipped (used to ignore nodes), nothing is allocated
+ * 
+ * Params:
+ * - int start: the starting variable
+ * - int depth: max depth of the search (INT_MAX for the whole component)
+ * 
+ * Returns:
+ * - int: number of nodes found, which are frontier[0] .. frontier[count-1]
+*/
+int Partition::bfsMark(int start, int depth) {
+    int head = 0, tail = 0;
+    visited_epoch[start] = epoch;
+    bfs_depth[start] = 0;
+    frontier[tail++] = start;
+
+    while(head < tail) {
+        int curr = frontier[head++];
+        if(bfs_depth[curr] == depth) continue;
+
+        for(int i = adj_start[curr]; i < adj_start[curr+1]; ++i) {
+            int neighbor = adj[i];
+            if(visited_epoch[neighbor] == epoch) continue;
+            visited_epoch[neighbor] = epoch;
+            bfs_depth[neighbor] = bfs_depth[curr] + 1;
+            frontier[tail++] = neighbor;
         }
     }
+
+    return tail;
 }
 
 
@@ -2594,55 +3164,27 @@ void Partition::createGraph() {
  * Returns:
  * - vector<int>: sizes of different partitions
 */
-vector<int> Partition::partitionBFS(unordered_set<int> ignore) {
+vector<int> Partition::partitionBFS(const unordered_set<int>& ignore) {
     vector<int> partition_sizes;
 
     // If graph is empty return false
-    if(edges.size() == 0) {
+    if(adj.size() == 0) {
         return partition_sizes;
     }
 
-    // Pick start variable of search
-    int start = 1;
-
-    // Maintain explored set and BFS queue
-    unordered_set<int> explored;
-    queue<int> bfs_queue;
-
     // Mark ignored nodes as explored
-    for(int v : ignore) explored.insert(v);
+    newEpoch();
+    for(int v : ignore) {
+        if(v >= 1 && v <= vars) visited_epoch[v] = epoch;
+    }
 
     // Try every start var
     for(int start = 1; start <= vars; ++start) {
         // If already explored, skip 
-        if(explored.find(start) != explored.end()) continue;
-
-        explored.insert(start);
-        bfs_queue.push(start);
-
-        // Start search
-        int curr = 0;
-        int partition_size = 0;
-        while(bfs_queue.size()) {
-            // Pop from queue
-            curr = bfs_queue.front();
-            bfs_queue.pop();
-            ++partition_size;
-
-            // cout << "Popped " << curr << endl;
-
-            // Explore neighbors
-            for(int neighbor : edges[curr]) {
-                // Add to queue if neighbors not explored yet
-                if(explored.find(neighbor) == explored.end()) {
-                    bfs_queue.push(neighbor);
-                    explored.insert(neighbor);
-                }
-            }
-        }
+        if(visited_epoch[start] == epoch) continue;
 
         // Add partition to set
-        partition_sizes.push_back(partition_size);
+        partition_sizes.push_back(bfsMark(start, INT_MAX));
     }
 
     return partition_sizes;
@@ -2677,45 +3219,10 @@ vector<int> Partition::partitionBFS() {
  * - unordered_set<int>: the variables that fit the criteria (the nodes)
 */
 unordered_set<int> Partition::neighborsBFS(int start, int depth) {
-    unordered_set<int> result = {start};
-    
-    if(depth == 0) return result;
-
-    // Maintain depth of each node that has been explored
-    unordered_map<int, int> found_depths;
-    found_depths[start] = 0;
-
-    // BFS Queue
-    queue<int> bfs_queue;
-    bfs_queue.push(start);
-
-    // BFS loop
-    while(bfs_queue.size()) {
-        // Get current var
-        int curr = bfs_queue.front();
-        bfs_queue.pop();
+    newEpoch();
+    int count = bfsMark(start, depth);
 
-        // Add to result
-        result.insert(curr);
-
-        // If already at max depth, continue (don't add neighbors to queue)
-        if(found_depths[curr] == depth) continue;
-
-        // Explore neighbors
-        for(int neighbor : edges[curr]) {
-            // If not found yet
-            if(found_depths.find(neighbor) == found_depths.end()) {
-                // Mark its depth
-                found_depths[neighbor] = found_depths[curr] + 1;
-
-                // Add to queue
-                bfs_queue.push(neighbor);
-            }
-        }
-    }
-
-    // Return the result
-    return result;
+    return unordered_set<int>(frontier.begin(), frontier.begin() + count);
 }
 
 
@@ -2735,15 +3242,16 @@ unordered_set<int> Partition::neighborsBFS(int start, int depth) {
  * - int: the number of clauses according to the above criteria
 */
 int Partition::neighborsClauseCount(int start, int depth) {
-    // Run a BFS to get all variables to focus on
-    unordered_set<int> neighbors = neighborsBFS(start, depth);
+    // Run a BFS to mark all variables to focus on
+    newEpoch();
+    bfsMark(start, depth);
 
     // Count all clauses that have at least one neighbor
     int count = 0;
-    for(vector<int> clause : formula) {
+    for(const vector<int>& clause : formula) {
         bool found = false;
         for(int lit : clause) {
-            if(neighbors.count(abs(lit))) {
+            if(visited_epoch[abs(lit)] == epoch) {
                 found = true;
                 break;
             }
@@ -2757,41 +3265,286 @@ int Partition::neighborsClauseCount(int start, int depth) {
 
 
 /**
- * Helper function to generate combinations (to remove)
- * 
- * Params:
- * - result: resulting combinations
- * - combination: current combination
- * - start: index
- * - d: length of combination
- * - vars: total number of vars
+ * Finds articulation points and biconnected components of the graph (Tarjan, iterative DFS),
+ * along with the sizes of the pieces each articulation point cuts off. Linear time
  * 
+ * Returns:
+ * - int: number of articulation points
+ * - articulation_points, blocks, ap_pieces, component_id, component_sizes are set
 */
-void generateCombinations(set<vector<int>>& result, vector<int>& combination, int start, int d, int vars) {
-    if (d == 0) {
-        result.insert(combination);
-        return;
-    }
+int Partition::findArticulationPoints() {
+    articulation_points.clear();
+    blocks.clear();
+    ap_pieces.assign(vars+1, vector<int>());
+    component_id.assign(vars+1, -1);
+    component_sizes.clear();
+
+    vector<int> disc(vars+1, 0), low(vars+1, 0), parent(vars+1, 0), next_edge(vars+1, 0), subtree(vars+1, 0);
+    vector<int> dfs_stack, vertex_stack;
+    int timer = 0;
+
+    for(int root = 1; root <= vars; ++root) {
+        if(disc[root]) continue;
+
+        int comp = component_sizes.size();
+        disc[root] = low[root] = ++timer;
+        next_edge[root] = adj_start[root];
+        subtree[root] = 1;
+        component_id[root] = comp;
+        dfs_stack.push_back(root);
+        vertex_stack.push_back(root);
+
+        while(dfs_stack.size()) {
+            int u = dfs_stack.back();
+
+            // Explore next edge of u
+            if(next_edge[u] < adj_start[u+1]) {
+                int w = adj[next_edge[u]++];
+                if(!disc[w]) {
+                    parent[w] = u;
+                    disc[w] = low[w] = ++timer;
+                    next_edge[w] = adj_start[w];
+                    subtree[w] = 1;
+                    component_id[w] = comp;
+                    dfs_stack.push_back(w);
+                    vertex_stack.push_back(w);
+                } else if(w != parent[u]) {
+                    low[u] = min(low[u], disc[w]);
+                }
+                continue;
+            }
 
-    for (int i = start; i <= vars; ++i) {
-        combination.push_back(i);
-        generateCombinations(result, combination, i + 1, d - 1, vars);
-        combination.pop_back();
+            // u is finished
+            dfs_stack.pop_back();
+            int p = parent[u];
+            if(!p) continue;
+
+            low[p] = min(low[p], low[u]);
+            subtree[p] += subtree[u];
+
+            // p separates u's subtree from the rest: pop the block
+            if(low[u] >= disc[p]) {
+                ap_pieces[p].push_back(subtree[u]);
+
+                vector<int> block = {p};
+                int v;
+                do {
+                    v = vertex_stack.back();
+                    vertex_stack.pop_back();
+                    block.push_back(v);
+                } while(v != u);
+                blocks.push_back(block);
+            }
+        }
+        vertex_stack.clear();
+
+        component_sizes.push_back(subtree[root]);
+    }
+
+    // Roots are only articulation points with 2+ children, others need at least 1 piece
+    for(int v = 1; v <= vars; ++v) {
+        bool root = (parent[v] == 0);
+        if(ap_pieces[v].size() >= (root ? 2 : 1)) articulation_points.push_back(v);
+        else ap_pieces[v].clear();
+    }
+
+    if(debug) {
+        cout << "Articulation points: " << articulation_points.size() << endl;
+        cout << "Biconnected components: " << blocks.size() << endl << endl;
+    }
+
+    return articulation_points.size();
+}
+
+/**
+ * Sizes of the partitions left after removing an articulation point (same as partitionBFS({ap}),
+ * but without a BFS). findArticulationPoints() must have been called
+ * 
+ * Params:
+ * - int ap: an articulation point
+ * 
+ * Returns:
+ * - vector<int>: sizes of the different partitions
+*/
+vector<int> Partition::sizesWithout(int ap) {
+    vector<int> sizes;
+    int comp = component_id[ap];
+
+    for(int c = 0; c < component_sizes.size(); ++c) {
+        if(c != comp) sizes.push_back(component_sizes[c]);
+    }
+
+    // Pieces cut off below ap, and what's left of the component above it
+    int rest = component_sizes[comp] - 1;
+    for(int piece : ap_pieces[ap]) {
+        sizes.push_back(piece);
+        rest -= piece;
     }
+    if(rest > 0) sizes.push_back(rest);
+
+    return sizes;
 }
 
 
+/**
+ * Finds a minimum vertex separator of the largest connected component with max-flow (Dinic)
+ * Each side is seeded with (up to) the first (balance * component size) vars of a BFS from
+ * opposite ends of the component, and the seeds can't be removed, which keeps the sides balanced
+ * 
+ * Params:
+ * - double balance: fraction of the component each side must keep (0 to 0.5)
+ * 
+ * Returns:
+ * - unordered_set<int>: vars to remove (empty if no separator exists)
+*/
+unordered_set<int> Partition::minVertexSeparator(double balance) {
+    unordered_set<int> separator;
+    if(component_sizes.empty()) findArticulationPoints();
+
+    // Largest component
+    int comp = max_element(component_sizes.begin(), component_sizes.end()) - component_sizes.begin();
+    int size = component_sizes[comp];
+    int seed_size = max(1, (int)(balance * size));
+    if(2 * seed_size >= size) return separator;
+
+    // Opposite ends: farthest var from any var, then farthest var from that one
+    int start = 1;
+    while(component_id[start] != comp) ++start;
+    newEpoch();
+    int a = frontier[bfsMark(start, INT_MAX) - 1];
+    newEpoch();
+    bfsMark(a, INT_MAX);
+    int b = frontier[size - 1];
+
+    // Seeds: 1 = source side, 2 = sink side, 3 = next to the source side (sink seeds can't touch source seeds)
+    vector<char> seed(vars+1, 0);
+    for(int i = 0; i < seed_size; ++i) seed[frontier[i]] = 1;
+    for(int i = 0; i < seed_size; ++i) {
+        int v = frontier[i];
+        for(int j = adj_start[v]; j < adj_start[v+1]; ++j) {
+            if(!seed[adj[j]]) seed[adj[j]] = 3;
+        }
+    }
+    newEpoch();
+    bfsMark(b, INT_MAX);
+    int added = 0;
+    for(int i = 0; i < size && added < seed_size; ++i) {
+        if(seed[frontier[i]]) continue;
+        seed[frontier[i]] = 2;
+        ++added;
+    }
+    for(int v = 1; v <= vars; ++v) {
+        if(seed[v] == 3) seed[v] = 0;
+    }
+    if(added == 0) return separator;
+
+    // Flow network: var v is split into in (2v) -> out (2v+1), source is 0, sink is 1
+    const int INF = INT_MAX / 2;
+    int nodes = 2*vars + 2;
+    vector<int> head(nodes, -1), next_arc, to, cap;
+    auto addArc = [&](int u, int v, int c) {
+        to.push_back(v); cap.push_back(c); next_arc.push_back(head[u]); head[u] = to.size()-1;
+        to.push_back(u); cap.push_back(0); next_arc.push_back(head[v]); head[v] = to.size()-1;
+    };
+    for(int v = 1; v <= vars; ++v) {
+        if(component_id[v] != comp) continue;
+        addArc(2*v, 2*v+1, seed[v] ? INF : 1);
+        if(seed[v] == 1) addArc(0, 2*v, INF);
+        if(seed[v] == 2) addArc(2*v+1, 1, INF);
+        for(int i = adj_start[v]; i < adj_start[v+1]; ++i) addArc(2*v+1, 2*adj[i], INF);
+    }
+
+    // Dinic
+    vector<int> level(nodes), curr_arc(nodes), path;
+    int flow = 0;
+    while(true) {
+        // Level graph
+        fill(level.begin(), level.end(), -1);
+        queue<int> q;
+        level[0] = 0;
+        q.push(0);
+        while(q.size()) {
+            int u = q.front();
+            q.pop();
+            for(int e = head[u]; e != -1; e = next_arc[e]) {
+                if(cap[e] > 0 && level[to[e]] == -1) {
+                    level[to[e]] = level[u] + 1;
+                    q.push(to[e]);
+                }
+            }
+        }
+        if(level[1] == -1) break;
+
+        // Blocking flow with iterative DFS
+        curr_arc = head;
+        path.clear();
+        int u = 0;
+        while(true) {
+            if(u == 1) {
+                int push = INF;
+                for(int e : path) push = min(push, cap[e]);
+                for(int e : path) {
+                    cap[e] -= push;
+                    cap[e^1] += push;
+                }
+                flow += push;
+                path.clear();
+                u = 0;
+                continue;
+            }
+
+            int& e = curr_arc[u];
+            while(e != -1 && !(cap[e] > 0 && level[to[e]] == level[u] + 1)) e = next_arc[e];
+
+            if(e == -1) {
+                // Dead end: retreat
+                if(u == 0) break;
+                level[u] = -1;
+                u = to[path.back() ^ 1];
+                path.pop_back();
+            } else {
+                path.push_back(e);
+                u = to[e];
+            }
+        }
+    }
+
+    // Separator: vars whose in-node is reachable from the source in the residual graph but out-node isn't
+    vector<char> reached(nodes, 0);
+    queue<int> q;
+    reached[0] = 1;
+    q.push(0);
+    while(q.size()) {
+        int u = q.front();
+        q.pop();
+        for(int e = head[u]; e != -1; e = next_arc[e]) {
+            if(cap[e] > 0 && !reached[to[e]]) {
+                reached[to[e]] = 1;
+                q.push(to[e]);
+            }
+        }
+    }
+    for(int v = 1; v <= vars; ++v) {
+        if(reached[2*v] && !reached[2*v+1]) separator.insert(v);
+    }
+
+    if(debug) cout << "Min vertex separator (balance " << balance << "): " << flow << " vars" << endl;
+
+    return separator;
+}
+
 
 /**
  * Finds a (minimal) set of variables to remove from graph to form a partition
- * Uses Iterative Deepening Search
+ * Candidates are single var cuts (articulation points) and min vertex separators
+ * from max-flow at several balances, so no combinations are enumerated
  * 
  * Params:
- * - int start_limit: starting depth of search
- * - int end_limit: ending depth of search
- * - string heur: used for DLS
+ * - int start_limit: min number of vars to remove
+ * - int end_limit: max number of vars to remove
+ * - string heur:
  *    - "half": find most optimal partition that splits into equal halves
- *    - "until_partition": ignores "start_depth" and "end_depth", and keeps iterating until a partition (of size 2 or more) is found
+ *    - "until_partition": ignores "start_depth" and "end_depth", and returns the smallest set that partitions the graph
  *    - other: returns first partition
  * 
  * Returns:
@@ -2804,85 +3557,88 @@ unordered_set<int> Partition::removeAndPartitionIDS(int start_depth, int end_dep
     // Maintain the best combination and its score so far
     int best_score = INT_MAX;
 
-    // Maintain best partition siezs
+    // Maintain best partition sizes
     vector<int> best_partition_sizes;
 
-    // Maintain average score
-    int total_score = 0;
-    int score_count = 0;
-
     if(heur == "until_partition") {
         start_depth = 1;
         end_depth = INT_MAX;
     }
 
-    // Iterate through all depths
-    for(int depth = start_depth; depth <= end_depth; ++depth) {
-        if(debug) cout << "Attempting depth " << depth << "..." << endl;
+    // Candidates (smallest first), with their partition sizes
+    vector<pair<unordered_set<int>, vector<int>>> candidates;
 
-        // Create all combinations of variables to remove of this depth
-        set<vector<int>> combinations;
-        vector<int> vec;
-        generateCombinations(combinations, vec, 1, depth, vars);
+    findArticulationPoints();
+    if(start_depth <= 1 && end_depth >= 1) {
+        for(int ap : articulation_points) {
+            candidates.push_back(make_pair(unordered_set<int>({ap}), sizesWithout(ap)));
+        }
 
-        // Check all combinations
-        for(vector<int> combination : combinations) {
-            unordered_set<int> c;
-            for(int v : combination) c.insert(v);
+        // Already partitioned graph: any var works, so (as when every var was tried) the first var is a candidate,
+        // and so is the first var of the largest partition (best "half" score, since removing it only shrinks that partition)
+        if(partitionBFS().size() > 1) {
+            int largest = 0, largest_start = 1;
+            newEpoch();
+            for(int v = 1; v <= vars; ++v) {
+                if(visited_epoch[v] == epoch) continue;
+                int size = bfsMark(v, INT_MAX);
+                if(size > largest) {
+                    largest = size;
+                    largest_start = v;
+                }
+            }
 
-            // Check if partitioned
-            vector<int> partition_sizes = removeAndCheckPartition(c, edges);
+            candidates.push_back(make_pair(unordered_set<int>({1}), partitionBFS({1})));
+            if(largest_start != 1) {
+                candidates.push_back(make_pair(unordered_set<int>({largest_start}), partitionBFS({largest_start})));
+            }
+        }
+    }
 
-            // cout << "Curr Combination: ";
-            // for(int curr_num : c) cout << curr_num << " ";
-            // cout << endl << "Partition Sizes: ";
-            // for(int ps : partition_sizes) cout << ps << " ";
-            // cout << endl << endl;
+    vector<double> balances = {0.45, 0.4, 0.3, 0.2, 0.1, 0.05};
+    for(double balance : balances) {
+        unordered_set<int> separator = minVertexSeparator(balance);
+        if(separator.empty() || separator.size() < start_depth || separator.size() > end_depth) continue;
+        candidates.push_back(make_pair(separator, partitionBFS(separator)));
+    }
 
-            // Check heuristic
-            if(heur == "half") {
-                // Score the partition by comparing it to half of the number of remaining variables
-                // int half = (vars - combination.size()) / 2;
-                int half = vars/2;
+    stable_sort(candidates.begin(), candidates.end(), [](const pair<unordered_set<int>, vector<int>>& x, const pair<unordered_set<int>, vector<int>>& y) {
+        return x.first.size() < y.first.size();
+    });
 
-                int score = 0;
-                for(int s : partition_sizes) {
-                    score += (s - half)*(s - half);
-                }
+    for(pair<unordered_set<int>, vector<int>>& candidate : candidates) {
+        unordered_set<int>& c = candidate.first;
+        vector<int>& partition_sizes = candidate.second;
 
-                // Update if new optimal score found
-                if(score < best_score) {
-                    best_score = score;
-                    removed_vars = c;
-                    best_partition_sizes = partition_sizes;
-                }
+        // Check heuristic
+        if(heur == "half") {
+            // Score the partition by comparing it to half of the number of variables
+            int half = vars/2;
 
-                // Add to count
-                total_score += score;
-                ++score_count;
+            int score = 0;
+            for(int s : partition_sizes) {
+                score += (s - half)*(s - half);
             }
-            // Until first partition
-            else if(heur == "until_partition") {
-                if(partition_sizes.size() > 1) {
-                    if(debug) {
-                        cout << "Best vars to remove: ";
-                        for(int v : c) cout << v << " ";
-                        cout << endl;
-                        cout << "Resulting Partition Sizes: ";
-                        for(int ps : partition_sizes) cout << ps << " ";
-                        cout << endl << endl;
-                    }
 
-                    return c;
-                }
+            // Update if new optimal score found
+            if(score < best_score) {
+                best_score = score;
+                removed_vars = c;
+                best_partition_sizes = partition_sizes;
             }
-            // No heuristic - just return first partition found
-            else {
-                if(partition_sizes.size() > 1) {
-                    return c;
-                }
+        }
+        // Smallest partition, or first partition
+        else if(partition_sizes.size() > 1) {
+            if(debug) {
+                cout << "Best vars to remove: ";
+                for(int v : c) cout << v << " ";
+                cout << endl;
+                cout << "Resulting Partition Sizes: ";
+                for(int ps : partition_sizes) cout << ps << " ";
+                cout << endl << endl;
             }
-            
+
+            return c;
         }
     }
 
@@ -2894,18 +3650,16 @@ unordered_set<int> Partition::removeAndPartitionIDS(int start_depth, int end_dep
         cout << "Resulting Partition Sizes: ";
         for(int ps : best_partition_sizes) cout << ps << " ";
         cout << endl << endl;
-
-        cout << "Average Score: " << total_score/score_count << endl;
     }
 
-
     return removed_vars;
 }
 
 
 /**
  * Removes variables (by highest degree in graph) until graph is partitioned
- * 
+ * The removal order is found first (degrees are updated as vars are removed), then vars are
+ * added back in reverse with union-find, so no BFS is needed after each removal
  * 
  * Params:
  * - num_remove: number of vars to remove
@@ -2915,37 +3669,96 @@ unordered_set<int> Partition::removeAndPartitionIDS(int start_depth, int end_dep
  * 
 */
 map<int, vector<int>> Partition::removeAndPartitionGreedy(int num_remove) {
-    // Maintain set of vars to remove
-    unordered_set<int> remove;
-
     // Map to return
     map<int, vector<int>> result;
 
-    // Loop indefinitely
-    for(int i = 1; i <= num_remove; ++i) {
-        // Find the var with most edges
-        int curr_var = 0, count = INT_MIN;
-        for(pair<int, set<int>> p : edges) {
-            if((int)p.second.size() > count) {
-                count = p.second.size();
-                curr_var = p.first;
-            }
+    // Removal order: highest current degree first (ties to the smallest var)
+    vector<int> degree(vars+1, 0);
+    priority_queue<pair<int, int>> heap;
+    for(int v = 1; v <= vars; ++v) {
+        degree[v] = adj_start[v+1] - adj_start[v];
+        if(degree[v]) heap.push(make_pair(degree[v], -v));
+    }
+
+    vector<char> removed(vars+1, 0);
+    vector<int> order;
+    // Vars whose neighbors were all removed stay in the heap (with degree 0), so they're removed too
+    while(order.size() < num_remove && heap.size()) {
+        pair<int, int> top = heap.top();
+        heap.pop();
+        int v = -top.second;
+        if(removed[v] || top.first != degree[v]) continue;
+
+        removed[v] = 1;
+        order.push_back(v);
+        for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+            int u = adj[i];
+            if(removed[u]) continue;
+            --degree[u];
+            heap.push(make_pair(degree[u], -u));
+        }
+    }
+
+    // Union-find over the vars left after all removals
+    vector<int> parent(vars+1), size(vars+1, 1), min_var(vars+1);
+    for(int v = 0; v <= vars; ++v) parent[v] = min_var[v] = v;
+    auto find = [&](int v) {
+        while(parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    auto unite = [&](int a, int b) {
+        a = find(a);
+        b = find(b);
+        if(a == b) return;
+        if(size[a] < size[b]) swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        min_var[a] = min(min_var[a], min_var[b]);
+    };
+    for(int v = 1; v <= vars; ++v) {
+        if(removed[v]) continue;
+        for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+            if(!removed[adj[i]]) unite(v, adj[i]);
         }
+    }
+
+    // Sizes, ordered by smallest var in each partition (same order as partitionBFS)
+    auto partitionSizes = [&]() {
+        vector<pair<int, int>> parts;
+        for(int v = 1; v <= vars; ++v) {
+            if(!removed[v] && find(v) == v) parts.push_back(make_pair(min_var[v], size[v]));
+        }
+        sort(parts.begin(), parts.end());
 
-        // Remove var
-        removeNode(curr_var, edges);
-        remove.insert(curr_var);
+        vector<int> sizes;
+        for(pair<int, int> p : parts) sizes.push_back(p.second);
+        return sizes;
+    };
 
-        // Calculate partitions
-        vector<int> partition_sizes = partitionBFS(remove);
+    // Once every var with edges is removed, further removals leave the partitions as they are
+    vector<int> last_sizes = partitionSizes();
+    for(int i = order.size() + 1; i <= num_remove; ++i) result[i] = last_sizes;
 
-        result[i] = partition_sizes;
+    // Walk back through the removals, adding each var back after recording the sizes
+    for(int i = order.size(); i >= 1; --i) {
+        result[i] = partitionSizes();
 
-        if(debug) {
+        int v = order[i-1];
+        removed[v] = 0;
+        for(int j = adj_start[v]; j < adj_start[v+1]; ++j) {
+            if(!removed[adj[j]]) unite(v, adj[j]);
+        }
+    }
+
+    if(debug) {
+        for(int i = 1; i <= num_remove; ++i) {
             cout << "Vars Removed: ";
-            for(int v : remove) cout << v << " ";
+            for(int j = 0; j < min(i, (int)order.size()); ++j) cout << order[j] << " ";
             cout << endl << "Partition Sizes: ";
-            for(int ps : partition_sizes) cout << ps << " ";
+            for(int ps : result[i]) cout << ps << " ";
             cout << endl << endl;
         }
     }
@@ -3092,6 +3905,7 @@ void Partition::swapBetweenSets(set<int>& s1, set<int>& s2, int a, int b) {
 /**
  * Uses Kernighan-Lin algorithm to find a partition of equal size of the graph which 
  * minimizes the amount of edges that cross the partitions
+ * Refinement is done with Fiduccia-Mattheyses passes (see fmBisection), so each move is O(degree)
  * 
  * Params:
  * - bool shuffle_vars: randomly creates initial assignment
@@ -3116,86 +3930,13 @@ vector<set<int>> Partition::kernighanLinAlg(bool shuffle_vars) {
     for(int v = 1; v <= vars/2; ++v) partitions[0].insert(orderings[v-1]);
     for(int v = (vars/2)+1; v <= vars; ++v) partitions[1].insert(orderings[v-1]);
 
-    // Create set of vars that can be explored
-    unordered_set<int> remaining;
-    for(int v = 1; v <= vars; ++v) remaining.insert(v);
+    // Refine with FM passes (gain buckets on the CSR graph)
+    vector<int> part(vars+1, 0);
+    for(int v : partitions[1]) part[v] = 1;
+    int minimum_cost = fmBisection(part);
 
-    // Maintain a overall minimum cost, and best partition
-    vector<set<int>> best_partitions = partitions;
-    int minimum_cost = INT_MAX;
-
-    // Iterate until no (or 1) vars remaining
-    while(remaining.size() > 1) {
-        // Calculate curr cost of partition
-        int curr_cost = calculatePartitionCost(partitions);
-
-        if(debug) {
-            cout << "Current Partitions: " << endl << partitions;
-            cout << "Cost: " << curr_cost << endl << endl;
-        }
-
-        // Maintain best cost, and candidates A and B to swap
-        int best_cost = INT_MAX;
-        int best_a = 0, best_b = 0;
-
-        // Iterate through each var in sets A and B
-        set<int> A = partitions[0], B = partitions[1];
-        for(int a : A) {
-            // Ensure that this var hasn't been chosen yet
-            if(remaining.find(a) == remaining.end()) {
-                continue;
-            }
-
-            for(int b : B) {
-                // Ensure that this var hasn't been chosen yet
-                if(remaining.find(b) == remaining.end()) {
-                    continue;
-                }
-
-                // Temporarily swap a and b
-                swapBetweenPartitions(partitions, a, b);
-
-                // Check cost
-                int new_cost = calculatePartitionCost(partitions);
-
-                // Swap back a and b
-                swapBetweenPartitions(partitions, b, a);
-
-                // Update cost if needed
-                if(new_cost <= best_cost) {
-                    best_cost = new_cost;
-                    best_a = a;
-                    best_b = b;
-                }
-            }
-        }
-
-        if(debug) {
-            cout << "\tBest Swap: " << best_a << " and " << best_b << endl;
-            cout << "\tSwapped Cost: " << best_cost << endl << endl;
-        }
-
-
-        // If best cost is same as or worse than curr cost, exit loop (no improvement)
-        if(best_cost >= curr_cost) {
-            if(debug) cout << "Swap doesn't improve score. Breaking..." << endl << endl;
-            break;
-        }
-
-        // Make the best swap
-        swapBetweenPartitions(partitions, best_a, best_b);
-
-        // Mark best_a and best_b as used
-        remaining.erase(best_a);
-        remaining.erase(best_b);
-
-        // Update best partitions if needed
-        if(best_cost < minimum_cost) {
-            minimum_cost = best_cost;
-            best_partitions = partitions;
-        }
-
-    }
+    vector<set<int>> best_partitions(2);
+    for(int v = 1; v <= vars; ++v) best_partitions[part[v]].insert(v);
 
     cout << "Best Partitions: " << endl << best_partitions;
     cout << "Best Cost: " << minimum_cost << endl << endl;
@@ -3207,6 +3948,7 @@ vector<set<int>> Partition::kernighanLinAlg(bool shuffle_vars) {
 /**
  * Modified KL-algorithm to find partition of equal size plus some variables removed to
  * minimize amount of edges that cross the partitions
+ * Swaps between the partitions and removed vars are done with gain buckets (see fmSeparator)
  * 
  * Params:
  * - int d: denotes number of vars to remove
@@ -3234,100 +3976,20 @@ vector<set<int>> Partition::nodeKLAlg1(int d, set<int>& removed, bool shuffle_va
     for(int v = ((vars-d)/2)+1; v <= (vars-d); ++v) partitions[1].insert(orderings[v-1]);
     for(int v = vars-d+1; v <= vars; ++v) removed.insert(orderings[v-1]);
 
-    // Create set of variables that can be explored
-    unordered_set<int> remaining;
-    for(int v = 1; v <= vars; ++v) remaining.insert(v);
-
-    // Maintain an overall minimum cost, and best partition
-    vector<set<int>> best_partitions = partitions;
-    int minimum_cost = calculatePartitionCost(partitions, removed);
-
-    // Iterate until not enough vars remaining
-    while(remaining.size() > 0) {
-        // Calculate current cost of partition
-        int curr_cost = calculatePartitionCost(partitions, removed);
-
-        if(debug) {
-            cout << "Current Partitions: " << endl << partitions;
-            cout << "Removed: ";
-            for(int r : removed) cout << r << " ";
-            cout << endl << "Cost: " << curr_cost << endl << endl;
-        }
-
-        // Maintain best cost, and candidates x and r to swap 
-        // x is either in A or B, and r is in removed
-        int best_cost = INT_MAX;
-        int best_x = 0, best_r = 0;
-
-        // Iterate through each var that is not in removed (essentially, all vars in A and B)
-        for(int x = 1; x <= vars; ++x) {
-            if(removed.count(x)) continue;
-
-            // Ensure variable hasn't been used yet 
-            if(!remaining.count(x)) continue;
-
-            // Iterate through each var in removed
-            set<int> removed_copy = removed;
-            for(int r : removed_copy) {
-                // Temporarily swap x and r, remembering which set x came from
-                bool x_in_A = false;
-                if(partitions[0].count(x)) {
-                    swapBetweenSets(partitions[0], removed, x, r);
-                    x_in_A = true;
-                } else {
-                    swapBetweenSets(partitions[1], removed, x, r);
-                }
-
-                // Check cost
-                int new_cost = calculatePartitionCost(partitions, removed);
-
-                // Swap back x and r 
-                if(x_in_A) {
-                    swapBetweenSets(partitions[0], removed, r, x);
-                } else {
-                    swapBetweenSets(partitions[1], removed, r, x);
-                }
-
-                // Update cost if needed
-                if(new_cost <= best_cost) {
-                    best_cost = new_cost;
-                    best_x = x;
-                    best_r = r;
-                }
-
-            }
-        }
-
-        if(debug) {
-            cout << "\tBest Swap: " << best_x << " and " << best_r << endl;
-            cout << "\tSwapped Cost: " << best_cost << endl << endl;
-        }
-
-        // If best cost same as or worse than curr cost, exit
-        if(best_cost >= curr_cost) {
-            if(debug) cout << "Swap doesn't improve score. Breaking..." << endl << endl;
-            break;
-        }
-
-        // Make the best swap 
-        if(partitions[0].count(best_x)) {
-            swapBetweenSets(partitions[0], removed, best_x, best_r);
-        } else {
-            swapBetweenSets(partitions[1], removed, best_x, best_r);
-        }
-
-        // Mark best_x as used 
-        remaining.erase(best_x);
-
-        // Update best partitions if needed 
-        if(best_cost < minimum_cost) {
-            minimum_cost = best_cost;
-            best_partitions = partitions;
-        }
+    // Refine with FM swaps between the sides and removed vars (gain buckets on the CSR graph)
+    vector<int> part(vars+1, 0);
+    for(int v : partitions[1]) part[v] = 1;
+    for(int v : removed) part[v] = 2;
+    int minimum_cost = fmSeparator(part);
 
+    partitions.assign(2, set<int>());
+    removed.clear();
+    for(int v = 1; v <= vars; ++v) {
+        if(part[v] == 2) removed.insert(v);
+        else partitions[part[v]].insert(v);
     }
 
-    // cout << "Best Partitions: " << endl << best_partitions;
+    // cout << "Best Partitions: " << endl << partitions;
     // cout << "Remove: ";
     // for(int r : removed) cout << r << " ";
     // cout << endl;
@@ -3451,13 +4113,34 @@ ostream &operator<<(ostream &os, Partition const &p) {
  * - string heur: {"round-robin", "random"}
  *   - round-robin: first clause in first subarray, second in second, ...
  *   - random: like round-robin, but clauses are shuffled beforehand
+ *   - multilevel: multilevel hypergraph partitioning (clauses are vertices, vars are nets), so that
+ *     vars touch as few subarrays (and groups of subarrays) as possible
 */
 void ClausePartition::createSubarrays(int num, string heur) {
-    unordered_set<string> possible_heurs = {"round-robin", "random"};
+    unordered_set<string> possible_heurs = {"round-robin", "random", "multilevel"};
     if(!possible_heurs.count(heur)) {
         cout << "ERROR: can't support provided heur " << heur << endl;
     }
 
+    subarrays.clear();
+    clause_subarrays.clear();
+
+    // Multilevel heuristic
+    if(heur == "multilevel") {
+        Hypergraph h;
+        h.fromFormula(vars, formula);
+
+        MultilevelPartition mp;
+        mp.debug = debug;
+        vector<int> part = mp.partition(h, num);
+
+        subarrays.resize(num);
+        for(int c = 1; c <= clauses; ++c) {
+            subarrays[part[c-1]].insert(c);
+            clause_subarrays[c] = part[c-1];
+        }
+    }
+
     // Round robin or random heuristic
     if(heur == "round-robin" || heur == "random") {
         // Initialize the subarrays vector
@@ -3506,34 +4189,20 @@ unordered_map<int, set<int>> ClausePartition::checkGroupings(int mask) {
     // groups_activated[i] is the set of all vars that activate i groups
     unordered_map<int, set<int>> groups_activated;
 
+    // Dense subarray number of each clause
+    vector<int> keys(clauses, 0);
+    for(pair<int, int> p : clause_subarrays) keys[p.first-1] = p.second;
+
+    // Count groups with the bitset kernel
+    GroupActivation activation(vars, formula, keys);
+    vector<vector<int>> per_var;
+    activation.countGroupsMasks({mask}, &per_var);
+
     // Maintain the largest group size of any var
     int most_groups = 0;
-
-    // Iterate through each variable
     for(int v = 1; v <= vars; ++v) {
-        // Maintain all groups that this var is in 
-        unordered_set<int> curr_var_groups;
-
-        // Iterate through each clause number that it is in
-        for(int c : var_clauses[v]) {
-            // From clause number, generate the subarray_num
-            int subarray_num = clause_subarrays[c];
-
-            // Apply mask on the clause_num to zero out the flexible bits 
-            int group = (subarray_num & (~mask));
-
-            // if(debug) {
-            //     cout << "Clause " << c << " is in subarray num " << subarray_num << " = group " << group << endl;
-            // }
-            
-            curr_var_groups.insert(group);
-        }
-
-        // Save the number of groups
-        int num_groups = curr_var_groups.size();
-        groups_activated[num_groups].insert(v);
-
-        most_groups = max(num_groups, most_groups);
+        groups_activated[per_var[0][v]].insert(v);
+        most_groups = max(per_var[0][v], most_groups);
     }
 
     // Print out info
@@ -3550,43 +4219,143 @@ unordered_map<int, set<int>> ClausePartition::checkGroupings(int mask) {
     return groups_activated;
 }
 
+/**
+ * Checks effectiveness of groupings for many masks in one pass (see checkGroupings)
+ * 
+ * Params:
+ * - const vector<int>& masks: the masks used to put subarrays into groups
+ * - int num_threads: 0 = all hardware threads
+ * 
+ * Returns:
+ * - vector<vector<int>>: for each mask, [i] is the number of vars that activate i groups
+*/
+vector<vector<int>> ClausePartition::checkGroupingsMasks(const vector<int>& masks, int num_threads) {
+    vector<int> keys(clauses, 0);
+    for(pair<int, int> p : clause_subarrays) keys[p.first-1] = p.second;
+
+    GroupActivation activation(vars, formula, keys);
+    vector<vector<int>> histograms = activation.countGroupsMasks(masks, nullptr, num_threads);
+
+    if(debug) {
+        for(int m = 0; m < masks.size(); ++m) {
+            cout << "Mask " << masks[m] << ":" << endl;
+            for(int g = 1; g < histograms[m].size(); ++g) {
+                if(histograms[m][g]) cout << g << " groups: " << histograms[m][g] << " vars" << endl;
+            }
+            cout << endl;
+        }
+    }
+
+    return histograms;
+}
+
 
 
 /**
- * Helper function that directly maps clauses to their groups
+ * Counter-based random number (splitmix64 finalizer on key + counter), so any element of any
+ * random stream can be computed independently of the others
+ * 
+ * Params:
+ * - unsigned long long key: identifies the stream (ex: seed and trial)
+ * - unsigned long long counter: position in the stream
+ * 
+ * Returns:
+ * - unsigned long long: 64 random bits
+*/
+unsigned long long counterRandom(unsigned long long key, unsigned long long counter) {
+    unsigned long long z = key + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Maps clauses to their groups. Clause at position p of the order goes to subarray p % num_subarrays, 
+ * and each group has num_groups consecutive subarrays. Randomized orders are a Fisher-Yates shuffle driven 
+ * by counterRandom(seed, trial), so the same (seed, trial) always gives the same mapping on any thread
  * 
  * Params:
  * - int num_clauses: number of clauses in formula
+ * - bool randomize: if true, shuffles the clause order
  * - int num_subarrays: number of subarrays
- * - int num_groups: number of groups
+ * - int num_groups: number of subarrays per group
+ * - unsigned long long seed: seed of the shuffle
+ * - unsigned long long trial: trial number (each trial is a different permutation)
  * 
  * Returns:
- * - unordered_map<int, int>: map from clause numbers to group numbers
+ * - vector<int>: [c] is the group of clause c (0-indexed clauses)
 */
-unordered_map<int, int> findGroupsMappingHelper(int num_clauses, bool randomize, int num_subarrays, int num_groups) {
-    unordered_map<int, int> mappings;
-
+vector<int> findGroupsMappingDense(int num_clauses, bool randomize, int num_subarrays, int num_groups, unsigned long long seed, unsigned long long trial) {
     // Create clause order
-    vector<int> order;
-    for(int c = 1; c <= num_clauses; ++c) order.push_back(c);
+    vector<int> order(num_clauses);
+    for(int c = 0; c < num_clauses; ++c) order[c] = c;
 
     // Shuffle order if needed
     if(randomize) {
-        random_device rd;
-        mt19937 g(rd());
-        shuffle(order.begin(), order.end(), g);
+        unsigned long long key = counterRandom(seed, trial);
+        for(int i = num_clauses - 1; i > 0; --i) {
+            // Random index in [0, i]
+            int j = (int)(((unsigned __int128)counterRandom(key, i) * (unsigned long long)(i + 1)) >> 64);
+            swap(order[i], order[j]);
+        }
     }
 
-    // Iterate through each clause
-    for(int c = 1; c <= num_clauses; ++c) {
-        // Create mapping
-        int g = ((c - 1) % num_subarrays) / num_groups;
+    vector<int> mapping(num_clauses);
+    for(int p = 0; p < num_clauses; ++p) {
+        mapping[order[p]] = (p % num_subarrays) / num_groups;
+    }
+
+    return mapping;
+}
 
-        // cout << "Clause " << c << ": " << "group " << g << endl;
+/**
+ * Creates many mappings (see findGroupsMappingDense) in parallel, trial t uses (seed, first_trial + t)
+ * 
+ * Params:
+ * - int num_clauses: number of clauses in formula
+ * - int trials: number of mappings to create
+ * - bool randomize: if true, shuffles the clause order
+ * - int num_subarrays: number of subarrays
+ * - int num_groups: number of subarrays per group
+ * - unsigned long long seed: seed of the shuffles
+ * - unsigned long long first_trial: trial number of the first mapping
+ * - int num_threads: 0 = all hardware threads
+ * 
+ * Returns:
+ * - vector<vector<int>>: [t][c] is the group of clause c in trial t
+*/
+vector<vector<int>> findGroupsMappings(int num_clauses, int trials, bool randomize, int num_subarrays, int num_groups, unsigned long long seed, unsigned long long first_trial, int num_threads) {
+    vector<vector<int>> mappings(trials);
+    parallelFor(trials, num_threads, [&](int t) {
+        mappings[t] = findGroupsMappingDense(num_clauses, randomize, num_subarrays, num_groups, seed, first_trial + t);
+    });
+    return mappings;
+}
 
-        // Use order
-        mappings[order[c]] = g;
+/**
+ * Helper function that directly maps clauses to their groups (map version of findGroupsMappingDense)
+ * 
+ * Params:
+ * - int num_clauses: number of clauses in formula
+ * - bool randomize: if true, shuffles the clause order
+ * - int num_subarrays: number of subarrays
+ * - int num_groups: number of subarrays per group
+ * - long long seed: seed of the shuffle (-1 = seeded from random_device, so every call is different)
+ * 
+ * Returns:
+ * - unordered_map<int, int>: map from clause numbers to group numbers
+*/
+unordered_map<int, int> findGroupsMappingHelper(int num_clauses, bool randomize, int num_subarrays, int num_groups, long long seed) {
+    unsigned long long key = seed;
+    if(seed < 0) {
+        random_device rd;
+        key = ((unsigned long long)rd() << 32) | rd();
     }
+    vector<int> dense = findGroupsMappingDense(num_clauses, randomize, num_subarrays, num_groups, key, 0);
+
+    unordered_map<int, int> mappings;
+    mappings.reserve(num_clauses);
+    for(int c = 0; c < num_clauses; ++c) mappings[c+1] = dense[c];
 
     return mappings;
 }
@@ -3607,32 +4376,22 @@ unordered_map<int, set<int>> runGroupsExperiment(int vars, vector<vector<int>>&
     // Keep track of results
     unordered_map<int, set<int>> result;
 
-    // Maintain map from variable to set of clauses
-    unordered_map<int, set<int>> var_to_clauses;
+    // Dense group of each clause (unmapped clauses are in group 0)
+    vector<int> keys(formula.size(), 0);
     for(int c = 0; c < formula.size(); ++c) {
-        for(int l : formula[c]) {
-            int var = abs(l);
-            var_to_clauses[var].insert(c+1);
-        }
+        auto it = mappings.find(c+1);
+        if(it != mappings.end()) keys[c] = it->second;
     }
 
-    // Iterate through each var
-    for(int v = 1; v <= vars; ++v) {
-        // Maintain set of groups activated
-        set<int> groups;
-
-        // Iterate through each clause this var is in
-        for(int c : var_to_clauses[v]) {
-            // Find the group number
-            int g = mappings[c];
-
-            groups.insert(g);
-        }
-
-        // Calculate number of groups this var activates
-        int num_groups = groups.size();
+    // Count groups with the bitset kernel (groups are the keys themselves)
+    GroupActivation activation(vars, formula, keys);
+    vector<int> identity(activation.num_keys);
+    for(int k = 0; k < identity.size(); ++k) identity[k] = k;
+    vector<vector<int>> per_var;
+    activation.countGroups({identity}, &per_var);
 
-        result[num_groups].insert(v);
+    for(int v = 1; v <= vars; ++v) {
+        result[per_var[0][v]].insert(v);
     }
 
     return result;
@@ -3656,984 +4415,5199 @@ void printGroupsResults(unordered_map<int, set<int>> results, int num_groups) {
 
 
 /**
- * Removes k literals from the formula, saving the answers to vars_2, clauses_2, formula_2
+ * Computes group histograms for many (num_subarrays, num_groups, randomize) configurations 
+ * in one pass over the var to clauses index (same grouping as findGroupsMappingHelper)
  * 
  * Params:
- * - unordered_set<int> remove: the literals that will be set, thus removing these variables
- * - bool recurse: if true, then if unit clauses caused by "remove", then will continue to recurse to remove them
- * - bool renumber: if true, then renumber after every set of removals
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - const vector<GroupsConfig>& configs: the configurations to evaluate
+ * - string csv_file: if not empty, writes one row per (config, trial, groups activated)
+ * - unsigned long long seed: seed for the randomized configurations
+ * - int num_threads: 0 = all hardware threads
  * 
  * Returns:
- * - bool: false if error occurs
+ * - vector<vector<int>>: histogram for each (config, trial) in order, [i] is the number of vars that activate i groups
 */
-bool DivideFormula::removeKLiterals(unordered_set<int> remove, bool recurse, bool renumber) {
-    // Keep track of a temporary formula (old version)
-    vector<vector<int>> tmp_formula = formula; 
+vector<vector<int>> runGroupsExperimentBatch(int vars, vector<vector<int>>& formula, const vector<GroupsConfig>& configs, string csv_file, unsigned long long seed, int num_threads) {
+    int num_clauses = formula.size();
+
+    // Each clause is its own key, so every grouping is just a clause to group table
+    vector<int> keys(num_clauses);
+    for(int c = 0; c < num_clauses; ++c) keys[c] = c;
+
+    vector<vector<int>> tables;
+    vector<pair<int, int>> labels; // (config, trial) of each table
+    for(int i = 0; i < configs.size(); ++i) {
+        const GroupsConfig& config = configs[i];
+        int trials = config.randomize ? max(1, config.trials) : 1;
+
+        // Each config gets its own trial range, so adding configs doesn't change the others
+        vector<vector<int>> mappings = findGroupsMappings(num_clauses, trials, config.randomize, config.num_subarrays, 
+                                                          config.num_groups, seed, (unsigned long long)i << 32, num_threads);
+        for(int t = 0; t < trials; ++t) {
+            tables.push_back(move(mappings[t]));
+            labels.push_back({i, t});
+        }
+    }
+
+    GroupActivation activation(vars, formula, keys);
+    vector<vector<int>> histograms = activation.countGroups(tables, nullptr, num_threads);
+
+    if(csv_file != "") {
+        ofstream out(csv_file);
+        if(!out.is_open()) {
+            cout << "ERROR: could not open " << csv_file << endl;
+            return histograms;
+        }
+
+        out << "config,num_subarrays,num_groups,randomize,trial,groups_activated,num_vars" << endl;
+        for(int h = 0; h < histograms.size(); ++h) {
+            const GroupsConfig& config = configs[labels[h].first];
+            string name = to_string(config.num_subarrays) + "_" + to_string(config.num_groups) + (config.randomize ? "_random" : "_ordered");
+            for(int g = 1; g < histograms[h].size(); ++g) {
+                if(histograms[h][g] == 0) continue;
+                out << name << "," << config.num_subarrays << "," << config.num_groups << "," << config.randomize << ","
+                    << labels[h].second << "," << g << "," << histograms[h][g] << endl;
+            }
+        }
+    }
 
-    int tmp_vars = vars;
-    renumber = false;
+    return histograms;
+}
 
-    // Loop
-    while(remove.size()) {
-        // Clear formula_2
-        formula_2.clear();
 
-        // Set new vars_2
-        vars_2 = tmp_vars - remove.size();
-
-        // Keep track of unit clause variables to satisfy
-        unordered_set<int> unit_clause_vars;
-        unordered_set<int> unit_clause_i;
+/**
+ * Builds the var to clauses CSR and the dense clause keys
+ * 
+ * Params:
+ * - int v: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - const vector<int>& keys: key of each clause (0-indexed clauses), ex: subarray numbers
+*/
+GroupActivation::GroupActivation(int v, vector<vector<int>>& formula, const vector<int>& keys) {
+    vars = v;
+    clause_key = keys;
+    num_keys = 1;
+    for(int k : clause_key) num_keys = max(num_keys, k+1);
 
-        // Add remove vars to assignment
-        // for(int lit : remove) {
-        //     cout << "assigned " << lit << endl;
-        // }
+    buildOccurrenceIndex(formula, vars, false, var_start, var_clauses);
+}
 
-        // Iterate through each clause
-        for(int c = 0; c < tmp_formula.size(); ++c) {
-            // Check if this clause is already satisfied
-            bool satisfied = false;
-            for(int l : tmp_formula[c]) {
-                if(remove.count(l)) {
-                    satisfied = true;
-                    break;
+/**
+ * Counts groups activated by each var for every grouping, in parallel over the vars
+ * 
+ * Params:
+ * - const vector<vector<int>>& key_to_group: key_to_group[g][k] is the group of key k in grouping g
+ * - vector<vector<int>>* per_var: if not null, returns (*per_var)[g][v] = number of groups var v activates
+ * - int num_threads: 0 = all hardware threads
+ * 
+ * Returns:
+ * - vector<vector<int>>: histogram for each grouping, [g][i] is the number of vars that activate i groups
+*/
+vector<vector<int>> GroupActivation::countGroups(const vector<vector<int>>& key_to_group, vector<vector<int>>* per_var, int num_threads) {
+    int num_groupings = key_to_group.size();
+
+    // Bitset size for each grouping. Clearing and counting a bitset costs groups/64 words per var,
+    // so groupings with more than bitset_max_groups groups count distinct groups with stamps instead
+    const int bitset_max_groups = 1024;
+    vector<int> num_groups(num_groupings, 1), words(num_groupings);
+    int max_words = 1, max_stamped = 1;
+    for(int g = 0; g < num_groupings; ++g) {
+        for(int group : key_to_group[g]) num_groups[g] = max(num_groups[g], group+1);
+        if(num_groups[g] <= bitset_max_groups) {
+            words[g] = (num_groups[g] + 63) / 64;
+            max_words = max(max_words, words[g]);
+        }
+        else {
+            words[g] = 0;
+            max_stamped = max(max_stamped, num_groups[g]);
+        }
+    }
+
+    vector<vector<int>> histograms(num_groupings);
+    for(int g = 0; g < num_groupings; ++g) histograms[g].assign(num_groups[g]+1, 0);
+    if(per_var) per_var->assign(num_groupings, vector<int>(vars+1, 0));
+
+    // Vars are split into chunks, each with its own bitset and histograms
+    int chunk_size = 1024;
+    int num_chunks = (vars + chunk_size - 1) / chunk_size;
+    mutex merge_mutex;
+
+    parallelFor(num_chunks, num_threads, [&](int chunk) {
+        vector<unsigned long long> bits(max_words);
+        vector<unsigned int> group_stamp(max_stamped, 0);
+        unsigned int stamp = 0;
+        vector<int> keys;
+        vector<vector<int>> local(num_groupings);
+        for(int g = 0; g < num_groupings; ++g) local[g].assign(num_groups[g]+1, 0);
+
+        int first = chunk * chunk_size + 1;
+        int last = min(vars, first + chunk_size - 1);
+        for(int v = first; v <= last; ++v) {
+            // Keys of this var's clauses, read once for all groupings
+            keys.clear();
+            for(int i = var_start[v]; i < var_start[v+1]; ++i) keys.push_back(clause_key[var_clauses[i]]);
+
+            for(int g = 0; g < num_groupings; ++g) {
+                const vector<int>& table = key_to_group[g];
+                int count = 0;
+                if(words[g] > 0) {
+                    fill(bits.begin(), bits.begin() + words[g], 0ULL);
+                    for(int k : keys) {
+                        int group = table[k];
+                        bits[group >> 6] |= 1ULL << (group & 63);
+                    }
+                    for(int w = 0; w < words[g]; ++w) count += __builtin_popcountll(bits[w]);
+                }
+                else {
+                    if(++stamp == 0) {
+                        fill(group_stamp.begin(), group_stamp.end(), 0);
+                        stamp = 1;
+                    }
+                    for(int k : keys) {
+                        int group = table[k];
+                        if(group_stamp[group] != stamp) {
+                            group_stamp[group] = stamp;
+                            ++count;
+                        }
+                    }
                 }
-            }
-            if(satisfied) continue;
-
-            // Else, construct the new clause
-            vector<int> new_clause;
-            for(int l : tmp_formula[c]) {
-                // If negative of this literal in remove set, skip literal
-                if(remove.count(-1*l)) continue;
 
-                // Add literal
-                new_clause.push_back(l);
-            }
-            if(new_clause.empty()) {
-                // If empty clause, that means it is unsatisfiable with this assignment
-                // cout << "ERROR: Clause " << c+1 << " is now not satisfied." << endl;
-                return false;
+                ++local[g][count];
+                if(per_var) (*per_var)[g][v] = count;
             }
+        }
 
-            // If unit clause, keep track of it
-            if(new_clause.size() == 1) {
-                // Make sure there's no contradiction
-                if(unit_clause_vars.count(-1*new_clause[0])) {
-                    // cout << "ERROR: Contradiction with variable " << abs(new_clause[0]) << " for unit clauses." << endl;
-                    return false;
-                }
-                // Add
-                unit_clause_vars.insert(new_clause[0]);
-                unit_clause_i.insert(formula_2.size());
-            }
+        lock_guard<mutex> lock(merge_mutex);
+        for(int g = 0; g < num_groupings; ++g) {
+            for(int i = 0; i < local[g].size(); ++i) histograms[g][i] += local[g][i];
+        }
+    });
 
-            // Else, can add to formula
-            formula_2.push_back(new_clause);
+    return histograms;
+}
 
+/**
+ * Counts groups activated by each var for many masks (keys are subarray numbers, and
+ * the group of subarray s is s & ~mask, like ClausePartition::checkGroupings)
+ * 
+ * Params:
+ * - const vector<int>& masks: the masks to evaluate
+ * - vector<vector<int>>* per_var: if not null, returns (*per_var)[m][v] = number of groups var v activates
+ * - int num_threads: 0 = all hardware threads
+ * 
+ * Returns:
+ * - vector<vector<int>>: histogram for each mask, [m][i] is the number of vars that activate i groups
+*/
+vector<vector<int>> GroupActivation::countGroupsMasks(const vector<int>& masks, vector<vector<int>>* per_var, int num_threads) {
+    // Number the distinct (s & ~mask) values densely, in order
+    vector<vector<int>> key_to_group(masks.size(), vector<int>(num_keys));
+    vector<int> index(num_keys);
+    for(int m = 0; m < masks.size(); ++m) {
+        fill(index.begin(), index.end(), -1);
+        int next = 0;
+        for(int k = 0; k < num_keys; ++k) {
+            int group = k & ~masks[m];
+            if(index[group] == -1) index[group] = next++;
+            key_to_group[m][k] = index[group];
         }
+    }
 
-        // Set clauses
-        clauses_2 = formula_2.size();
-
-        // Renumber the formula
-        if(renumber) renumberFormula(formula_2);
+    return countGroups(key_to_group, per_var, num_threads);
+}
 
-        // Mark as assigned
-        for(int l : remove) assignments_made.insert(l);
 
-        // Can now clear remove set
-        remove.clear();
+/**
+ * Creates the clause hypergraph of a formula: vertices are clauses (0-indexed), nets are vars
+ * Vars in fewer than 2 clauses are dropped, since they can't be cut
+*/
+void Hypergraph::fromFormula(int vars, vector<vector<int>>& formula) {
+    num_vertices = formula.size();
+    vertex_weight.assign(num_vertices, 1);
+
+    // Clauses of each var (CSR), each clause once
+    vector<int> count, var_clauses;
+    buildOccurrenceIndex(formula, vars, false, count, var_clauses, true);
+
+    net_start.assign(1, 0);
+    pins.clear();
+    net_weight.clear();
+    net_var.clear();
+    for(int v = 1; v <= vars; ++v) {
+        if(count[v+1] - count[v] < 2) continue;
+        pins.insert(pins.end(), var_clauses.begin() + count[v], var_clauses.begin() + count[v+1]);
+        net_start.push_back(pins.size());
+        net_weight.push_back(1);
+        net_var.push_back(v);
+    }
+    num_nets = net_weight.size();
 
-        if(recurse) {
-            // Find vars to remove again
-            for(int clause_i : unit_clause_i) {
-                remove.insert(formula_2[clause_i][0]);
-            }
-            // Formula 2 is now the new temp
-            tmp_formula = formula_2;
-            tmp_vars = vars_2;
-        } else {
-            // Update number of variables to be accurate
-            unordered_set<int> unique_vars;
-            for(vector<int> c : formula_2) {
-                for(int l : c) {
-                    unique_vars.insert(abs(l));
-                }
-            }
+    buildIncidence();
+}
 
-            vars_2 = unique_vars.size();
+/**
+ * Builds the vertex to nets incidence (vertex_start, incident_nets) from the pins of each net
+*/
+void Hypergraph::buildIncidence() {
+    vertex_start.assign(num_vertices+1, 0);
+    for(int p : pins) ++vertex_start[p+1];
+    for(int v = 0; v < num_vertices; ++v) vertex_start[v+1] += vertex_start[v];
 
-            return true;
+    incident_nets.assign(pins.size(), 0);
+    vector<int> pos(vertex_start.begin(), vertex_start.end()-1);
+    for(int e = 0; e < num_nets; ++e) {
+        for(int i = net_start[e]; i < net_start[e+1]; ++i) {
+            incident_nets[pos[pins[i]]++] = e;
         }
     }
-    
-    // Update number of variables to be accurate
-    unordered_set<int> unique_vars;
-    for(vector<int> c : formula_2) {
-        for(int l : c) {
-            unique_vars.insert(abs(l));
+}
+
+/**
+ * Returns the sum of vertex weights
+*/
+int Hypergraph::totalWeight() {
+    int total = 0;
+    for(int w : vertex_weight) total += w;
+    return total;
+}
+
+/**
+ * Returns the weighted number of nets that have pins on both sides of a bisection
+*/
+int hypergraphCut(Hypergraph& h, vector<int>& side) {
+    int cut = 0;
+    for(int e = 0; e < h.num_nets; ++e) {
+        int first = side[h.pins[h.net_start[e]]];
+        for(int i = h.net_start[e]+1; i < h.net_start[e+1]; ++i) {
+            if(side[h.pins[i]] != first) {
+                cut += h.net_weight[e];
+                break;
+            }
         }
     }
+    return cut;
+}
 
-    vars_2 = unique_vars.size();
-
-    return true;
+/**
+ * Returns the (connectivity - 1) cost of a k-way partition: sum over nets of
+ * weight * (number of parts the net touches - 1)
+*/
+int hypergraphConnectivity(Hypergraph& h, vector<int>& part) {
+    int cost = 0;
+    unordered_set<int> parts;
+    for(int e = 0; e < h.num_nets; ++e) {
+        parts.clear();
+        for(int i = h.net_start[e]; i < h.net_start[e+1]; ++i) parts.insert(part[h.pins[i]]);
+        cost += h.net_weight[e] * (parts.size() - 1);
+    }
+    return cost;
 }
 
 
 /**
- * Helper function that given vars to remove, generates all combinations of literals
- * Ex: Input = {1, 2}, Output = {{-1, -2}, {-1, 2}, {1, -2}, {1, 2}}
+ * Partitions the hypergraph into k parts of (nearly) equal weight, minimizing the 
+ * number of parts each net touches. Parts are made by recursive bisection, so parts that
+ * share a prefix of bits (ex: part >> 5) are also good partitions
  * 
  * Params:
- * - unordered_set<int> remove_vars: the vars to remove
+ * - Hypergraph& h: the hypergraph
+ * - int k: number of parts
  * 
  * Returns:
- * - vector<unordered_set<int>>: vector of literal combos
+ * - vector<int>: part of each vertex (0 to k-1)
 */
-vector<unordered_set<int>> generateLitsCombos(unordered_set<int> remove_vars) {
-    // Convert remove vars to vector
-    vector<int> remove_v;
-    for(int rv : remove_vars) remove_v.push_back(rv);
+vector<int> MultilevelPartition::partition(Hypergraph& h, int k) {
+    vector<int> ids(h.num_vertices);
+    for(int v = 0; v < h.num_vertices; ++v) ids[v] = v;
 
-    vector<unordered_set<int>> solution;
-    unordered_set<int> curr;
-    generateLitsCombosHelper(solution, remove_v, curr, 0);
-    return solution;
+    vector<int> result(h.num_vertices, 0);
+    recursiveBisect(h, k, 0, ids, result);
+
+    if(debug) {
+        cout << "Multilevel partition into " << k << " parts, (connectivity - 1) cost: ";
+        cout << hypergraphConnectivity(h, result) << endl;
+    }
+
+    return result;
 }
-void generateLitsCombosHelper(vector<unordered_set<int>>& answer, vector<int> remove_vars, unordered_set<int> curr, int i) {
-    if(curr.size() == remove_vars.size()) {
-        answer.push_back(curr);
+
+/**
+ * Recursively bisects h, assigning parts offset .. offset+k-1
+ * 
+ * Params:
+ * - Hypergraph& h: current (sub) hypergraph
+ * - int k: number of parts to split h into
+ * - int offset: first part number
+ * - vector<int>& ids: ids[v] is the original vertex of v
+ * - vector<int>& result: returned, part of each original vertex
+*/
+void MultilevelPartition::recursiveBisect(Hypergraph& h, int k, int offset, vector<int>& ids, vector<int>& result) {
+    if(k == 1 || h.num_vertices == 0) {
+        for(int v = 0; v < h.num_vertices; ++v) result[ids[v]] = offset;
         return;
     }
 
-    unordered_set<int> curr_2 = curr;
-    curr.insert(remove_vars[i]);
-    curr_2.insert(-1*remove_vars[i]);
+    // First half of the parts gets its share of the weight
+    int k0 = k / 2;
+    int target0 = (long long)h.totalWeight() * k0 / k;
+    vector<int> side = bisect(h, target0);
 
-    // Recurse
-    generateLitsCombosHelper(answer, remove_vars, curr, i+1);
-    generateLitsCombosHelper(answer, remove_vars, curr_2, i+1);
+    for(int s = 0; s < 2; ++s) {
+        vector<int> sub_to_h;
+        Hypergraph sub = subHypergraph(h, side, s, sub_to_h);
+
+        vector<int> sub_ids(sub_to_h.size());
+        for(int i = 0; i < sub_to_h.size(); ++i) sub_ids[i] = ids[sub_to_h[i]];
+
+        if(s == 0) recursiveBisect(sub, k0, offset, sub_ids, result);
+        else recursiveBisect(sub, k - k0, offset + k0, sub_ids, result);
+    }
 }
 
+/**
+ * Multilevel bisection of h: side 0 gets weight target0 (exactly, if all weights are 1)
+ * 
+ * Returns:
+ * - vector<int>: side (0 or 1) of each vertex
+*/
+vector<int> MultilevelPartition::bisect(Hypergraph& h, int target0) {
+    int total = h.totalWeight();
+    if(target0 <= 0) return vector<int>(h.num_vertices, 1);
+    if(target0 >= total) return vector<int>(h.num_vertices, 0);
+
+    int tol = max(1, (int)(imbalance * total));
+
+    // Coarsen (coarse[i] is level i+1, maps[i] takes level i to level i+1)
+    vector<Hypergraph> coarse;
+    vector<vector<int>> maps;
+    auto level = [&](int i) -> Hypergraph& { return (i == 0) ? h : coarse[i-1]; };
+
+    while(level(coarse.size()).num_vertices > coarsen_to) {
+        Hypergraph& finer = level(coarse.size());
+        vector<int> coarse_map;
+        Hypergraph c = coarsen(finer, coarse_map);
+        if(c.num_vertices > 0.9 * finer.num_vertices) break;
+
+        coarse.push_back(c);
+        maps.push_back(coarse_map);
+    }
+
+    // Bisect the coarsest level
+    int levels = coarse.size();
+    vector<int> side = initialBisection(level(levels), target0 - tol, target0 + tol);
+
+    // Project and refine, only the finest level has to be exact
+    for(int i = levels-1; i >= 0; --i) {
+        vector<int> finer_side(level(i).num_vertices);
+        for(int v = 0; v < finer_side.size(); ++v) finer_side[v] = side[maps[i][v]];
+        side = finer_side;
+
+        int slack = (i == 0) ? 0 : tol;
+        int cut = refine(level(i), side, target0 - slack, target0 + slack);
+        if(debug) cout << "\tLevel " << i << " (" << level(i).num_vertices << " vertices): cut " << cut << endl;
+    }
+    if(levels == 0) refine(h, side, target0, target0);
+
+    return side;
+}
 
 /**
- * Given a formula and a number k, returns the k most frequently appearing variables, in order
+ * Coarsens the hypergraph by heavy-edge matching: each vertex is paired with the unmatched
+ * neighbor it shares the most (small) nets with, weighted by 1/(net size - 1)
  * 
  * Params:
- * - int vars: the number of variables
- * - vector<vector<int>> formula: the SAT formula
- * - int k: the number of vars to return
+ * - Hypergraph& h: hypergraph to coarsen
+ * - vector<int>& coarse_map: returned, coarse vertex of each vertex
  * 
  * Returns:
- * - vector<int>: vars in order by occurrences
+ * - Hypergraph: the coarse hypergraph (nets with fewer than 2 pins are dropped)
 */
-vector<int> kMostOccurring(int vars, vector<vector<int>>& formula, int k) {
-    // Frequency map
-    unordered_map<int, int> var_freqs;
-    for(auto c : formula) {
-        for(auto l : c) {
-            ++var_freqs[abs(l)];
+Hypergraph MultilevelPartition::coarsen(Hypergraph& h, vector<int>& coarse_map) {
+    int n = h.num_vertices;
+    int max_weight = max(1, (int)(1.5 * h.totalWeight() / coarsen_to));
+
+    vector<int> order(n);
+    for(int v = 0; v < n; ++v) order[v] = v;
+    shuffle(order.begin(), order.end(), rng);
+
+    coarse_map.assign(n, -1);
+    vector<double> rating(n, 0);
+    vector<int> touched;
+    int nc = 0;
+
+    for(int u : order) {
+        if(coarse_map[u] != -1) continue;
+
+        // Rate unmatched neighbors
+        for(int i = h.vertex_start[u]; i < h.vertex_start[u+1]; ++i) {
+            int e = h.incident_nets[i];
+            int size = h.net_start[e+1] - h.net_start[e];
+            if(size > max_net_size) continue;
+
+            double r = (double)h.net_weight[e] / (size - 1);
+            for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) {
+                int v = h.pins[j];
+                if(v == u || coarse_map[v] != -1) continue;
+                if(rating[v] == 0) touched.push_back(v);
+                rating[v] += r;
+            }
         }
-    }
 
-    // Use priority queue for order
-    priority_queue<pair<int, int>> pq;
-    for(pair<int, int> p : var_freqs) {
-        // <occurrences, variable>
-        pq.push(make_pair(p.second, p.first));
+        int best = -1;
+        double best_rating = 0;
+        for(int v : touched) {
+            if(h.vertex_weight[u] + h.vertex_weight[v] <= max_weight && rating[v] > best_rating) {
+                best = v;
+                best_rating = rating[v];
+            }
+            rating[v] = 0;
+        }
+        touched.clear();
+
+        coarse_map[u] = nc;
+        if(best != -1) coarse_map[best] = nc;
+        ++nc;
     }
 
-    vector<int> solution;
+    // Contract
+    Hypergraph c;
+    c.num_vertices = nc;
+    c.vertex_weight.assign(nc, 0);
+    for(int v = 0; v < n; ++v) c.vertex_weight[coarse_map[v]] += h.vertex_weight[v];
 
-    // Loop k times
-    for(int i = 0; i < k; ++i) {
-        pair<int, int> p = pq.top();
-        pq.pop();
-        solution.push_back(p.second);
+    vector<int> stamp(nc, -1);
+    for(int e = 0; e < h.num_nets; ++e) {
+        int start = c.pins.size();
+        for(int i = h.net_start[e]; i < h.net_start[e+1]; ++i) {
+            int cv = coarse_map[h.pins[i]];
+            if(stamp[cv] == e) continue;
+            stamp[cv] = e;
+            c.pins.push_back(cv);
+        }
 
-        // cout << "var " << p.second << ": " << p.first << endl;
+        if(c.pins.size() - start < 2) {
+            c.pins.resize(start);
+        } else {
+            c.net_start.push_back(c.pins.size());
+            c.net_weight.push_back(h.net_weight[e]);
+        }
     }
-    return solution;
+    c.num_nets = c.net_weight.size();
+    c.buildIncidence();
+
+    return c;
 }
 
 /**
- * Runs divide and conquer experiment
+ * Finds an initial bisection by growing side 0 from a random vertex (BFS over nets),
+ * refining each try with FM and keeping the best
  * 
  * Params:
- * - Circuit c: includes information about the SAT formula
- * - unordered_set<int> remove_vars: the variables to remove (tries all literal combos)
- * - bool show_stats: prints out stats
- * - bool print: if true, prints info about each lit combo
+ * - Hypergraph& h: the (coarsest) hypergraph
+ * - int lo, int hi: allowed weight of side 0
+ * 
+ * Returns:
+ * - vector<int>: side (0 or 1) of each vertex
 */
-void runDivideExperiment(Circuit c, unordered_set<int> remove_vars, bool show_stats, bool print) {
-    vector<unordered_set<int>> lit_combos = generateLitsCombos(remove_vars);
-
-    // Keep track of stats
-    int successes = 0;
-    int total_vars = 0;
-    int total_clauses = 0;
-    int min_vars = INT_MAX;
-    int min_clauses = INT_MAX;
-
-    // Keep track of vars in order
-    vector<int> remove_vars_order;
-    for(int rv : remove_vars) remove_vars_order.push_back(rv);
-    sort(remove_vars_order.begin(), remove_vars_order.end());
+vector<int> MultilevelPartition::initialBisection(Hypergraph& h, int lo, int hi) {
+    int n = h.num_vertices;
+    int target = (lo + hi) / 2;
+
+    vector<int> best_side;
+    int best_cut = INT_MAX;
+
+    for(int t = 0; t < initial_tries; ++t) {
+        vector<int> side(n, 1);
+        vector<char> visited(n, 0);
+        vector<int> order(n);
+        for(int v = 0; v < n; ++v) order[v] = v;
+        shuffle(order.begin(), order.end(), rng);
+
+        queue<int> bfs_queue;
+        int next = 0, weight = 0;
+        while(weight < target) {
+            if(bfs_queue.empty()) {
+                while(next < n && visited[order[next]]) ++next;
+                if(next == n) break;
+                visited[order[next]] = 1;
+                bfs_queue.push(order[next]);
+            }
 
-    // Iterate through each combination
-    for(unordered_set<int> remove_lits : lit_combos) {
-        DivideFormula divide(c.vars, c.formula);
-        bool success = divide.removeKLiterals(remove_lits, true, true);
-        if(print) {
-            cout << "Removed Lits: ";
-            for(int var : remove_vars_order) {
-                if(remove_lits.count(var)) cout << var << " ";
-                else cout << -1 * var << " ";
+            int u = bfs_queue.front();
+            bfs_queue.pop();
+            if(weight + h.vertex_weight[u] > hi) continue;
+
+            side[u] = 0;
+            weight += h.vertex_weight[u];
+
+            for(int i = h.vertex_start[u]; i < h.vertex_start[u+1]; ++i) {
+                int e = h.incident_nets[i];
+                if(h.net_start[e+1] - h.net_start[e] > max_net_size) continue;
+                for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) {
+                    int v = h.pins[j];
+                    if(visited[v]) continue;
+                    visited[v] = 1;
+                    bfs_queue.push(v);
+                }
             }
-            cout << endl;
         }
-        if(success) {
-            if(print) {
-                cout << "\tVars Remaining: " << divide.vars_2 << "  (" << divide.vars_2 * 100.0 / c.vars << "%)" << endl;
-                cout << "\tClauses Remaining: " << divide.clauses_2 << "  (" << divide.clauses_2 * 100.0 / c.clauses << "%)" << endl;
+
+        int cut = refine(h, side, lo, hi);
+        if(cut < best_cut) {
+            best_cut = cut;
+            best_side = side;
+        }
+    }
+
+    return best_side;
+}
+
+/**
+ * FM refinement of a hypergraph bisection (minimizing the weighted cut)
+ * Moves may leave the weight bounds by one vertex, but only states within [lo, hi] are kept
+ * (if the start is out of bounds, moves are forced from the heavy side until it's in bounds)
+ * 
+ * Params:
+ * - Hypergraph& h: the hypergraph
+ * - vector<int>& side: side of each vertex, updated in place
+ * - int lo, int hi: allowed weight of side 0
+ * - int max_passes: max number of passes (stops earlier if a pass doesn't improve)
+ * 
+ * Returns:
+ * - int: final cut
+*/
+int MultilevelPartition::refine(Hypergraph& h, vector<int>& side, int lo, int hi, int max_passes) {
+    int n = h.num_vertices;
+
+    int max_vertex_weight = 1, max_gain = 1;
+    for(int v = 0; v < n; ++v) {
+        max_vertex_weight = max(max_vertex_weight, h.vertex_weight[v]);
+        int g = 0;
+        for(int i = h.vertex_start[v]; i < h.vertex_start[v+1]; ++i) g += h.net_weight[h.incident_nets[i]];
+        max_gain = max(max_gain, g);
+    }
+
+    // Distance of a side 0 weight from the bounds
+    auto outside = [&](int w) { return (w < lo) ? lo - w : ((w > hi) ? w - hi : 0); };
+
+    int cut = hypergraphCut(h, side);
+    for(int pass = 0; pass < max_passes; ++pass) {
+        // Pin counts on each side
+        vector<int> count[2] = {vector<int>(h.num_nets, 0), vector<int>(h.num_nets, 0)};
+        for(int e = 0; e < h.num_nets; ++e) {
+            for(int i = h.net_start[e]; i < h.net_start[e+1]; ++i) ++count[side[h.pins[i]]][e];
+        }
+
+        int weight = 0;
+        for(int v = 0; v < n; ++v) if(side[v] == 0) weight += h.vertex_weight[v];
+
+        // Gain of moving v = nets that become uncut - nets that become cut
+        GainBuckets buckets[2] = {GainBuckets(n, max_gain), GainBuckets(n, max_gain)};
+        for(int v = 0; v < n; ++v) {
+            int s = side[v], g = 0;
+            for(int i = h.vertex_start[v]; i < h.vertex_start[v+1]; ++i) {
+                int e = h.incident_nets[i];
+                if(count[s][e] == 1) g += h.net_weight[e];
+                if(count[1-s][e] == 0) g -= h.net_weight[e];
             }
+            buckets[s].insert(v, g);
+        }
+
+        auto add = [&](int u, int d) {
+            GainBuckets& b = buckets[side[u]];
+            if(b.in_bucket[u]) b.update(u, b.gain[u] + d);
+        };
+
+        int curr_cut = cut, best_cut = cut;
+        int best_outside = outside(weight);
+        int best_len = 0, since_best = 0;
+        vector<int> moves;
+
+        while(since_best < n/4 + 50) {
+            // Forced direction if out of bounds, else best gain among allowed moves
+            int from = -1;
+            int a = buckets[0].top(), b = buckets[1].top();
+            bool can0 = (a != -1) && (weight - h.vertex_weight[a] >= lo - max_vertex_weight);
+            bool can1 = (b != -1) && (weight + h.vertex_weight[b] <= hi + max_vertex_weight);
+            if(weight > hi) from = (a != -1) ? 0 : -1;
+            else if(weight < lo) from = (b != -1) ? 1 : -1;
+            else if(can0 && (!can1 || buckets[0].gain[a] >= buckets[1].gain[b])) from = 0;
+            else if(can1) from = 1;
+            if(from == -1) break;
+
+            int v = buckets[from].top();
+            int to = 1 - from;
+
+            curr_cut -= buckets[from].gain[v];
+            buckets[from].remove(v);
+            side[v] = to;
+            weight += (from == 0) ? -h.vertex_weight[v] : h.vertex_weight[v];
+            moves.push_back(v);
+
+            // Update gains of the other pins on v's nets
+            for(int i = h.vertex_start[v]; i < h.vertex_start[v+1]; ++i) {
+                int e = h.incident_nets[i];
+                int w = h.net_weight[e];
+
+                if(count[to][e] == 0) {
+                    for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) if(h.pins[j] != v) add(h.pins[j], w);
+                } else if(count[to][e] == 1) {
+                    for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) {
+                        int u = h.pins[j];
+                        if(u != v && side[u] == to) {
+                            add(u, -w);
+                            break;
+                        }
+                    }
+                }
 
-            // Track stats
-            ++successes;
-            total_vars += divide.vars_2;
-            total_clauses += divide.clauses_2;
-            min_vars = min(min_vars, divide.vars_2);
-            min_clauses = min(min_clauses, divide.clauses_2);
+                --count[from][e];
+                ++count[to][e];
+
+                if(count[from][e] == 0) {
+                    for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) if(h.pins[j] != v) add(h.pins[j], -w);
+                } else if(count[from][e] == 1) {
+                    for(int j = h.net_start[e]; j < h.net_start[e+1]; ++j) {
+                        int u = h.pins[j];
+                        if(u != v && side[u] == from) {
+                            add(u, w);
+                            break;
+                        }
+                    }
+                }
+            }
 
-        } else {
-            if(print) cout << "\tFAILED" << endl;
+            // Prefer states in bounds, then smaller cut
+            int curr_outside = outside(weight);
+            ++since_best;
+            if(curr_outside < best_outside || (curr_outside == best_outside && curr_cut < best_cut)) {
+                best_outside = curr_outside;
+                best_cut = curr_cut;
+                best_len = moves.size();
+                since_best = 0;
+            }
         }
-    }
 
-    if(show_stats) {
-        int avg_vars = (total_vars * 1.0 / successes);
-        int avg_clauses = (total_clauses * 1.0 / successes);
+        // Roll back to best prefix
+        for(int i = moves.size()-1; i >= best_len; --i) side[moves[i]] = 1 - side[moves[i]];
 
-        cout << endl << "Successes: " << successes << endl;
-        cout << "\nAvg Vars Remaining: " << avg_vars << endl;
-        cout << "\tPercent: " << avg_vars * 100.0 / c.vars << "%" << endl;
-        cout << "Avg Clauses Remaining: " << avg_clauses << endl;
-        cout << "\tPercent: " << avg_clauses * 100.0 / c.clauses << "%" << endl;
-        cout << "\nMin Vars Remaining: " << min_vars << endl;
-        cout << "\tPercent: " << min_vars * 100.0 / c.vars << "%" << endl;
-        cout << "Min Clauses Remaining: " << min_clauses << endl;
-        cout << "\tPercent: " << min_clauses * 100.0 / c.clauses << "%\n\n";
+        cut = best_cut;
+        if(best_len == 0) break;
     }
+
+    return cut;
 }
 
 /**
- * Same as above, but only divides using one variable
- * Returns a vector of size 2 of Circuit objects after dividing
+ * Creates the sub hypergraph of the vertices on one side (nets are cut down to those vertices)
  * 
  * Params:
- * - Formula f: includes information about the SAT formula
- * - int remove_var: var to remove
+ * - Hypergraph& h: the hypergraph
+ * - vector<int>& side: side of each vertex
+ * - int s: side to keep
+ * - vector<int>& sub_to_h: returned, sub_to_h[i] is the vertex in h of vertex i
  * 
  * Returns:
- * - vector<Formula>: size 2 where first Formula is after removing negative literal, second one after removing positive literal
- *   - if either causes error, will be a Formula object with f.vars set to -1
+ * - Hypergraph: the sub hypergraph
 */
-vector<Formula> runDivideExperimentSingleVar(Formula f, int remove_var) {
-    // Result
-    vector<Formula> result;
+Hypergraph MultilevelPartition::subHypergraph(Hypergraph& h, vector<int>& side, int s, vector<int>& sub_to_h) {
+    vector<int> h_to_sub(h.num_vertices, -1);
+    sub_to_h.clear();
 
-    // Iterate through each combination
-    vector<int> order = {-1 * abs(remove_var), abs(remove_var)};
-    for(int curr_var : order) {
-        // Remove the var
-        DivideFormula divide(f.vars, f.formula);
-        unordered_set<int> curr = {curr_var};
-        bool success = divide.removeKLiterals(curr, true, true);
+    Hypergraph sub;
+    for(int v = 0; v < h.num_vertices; ++v) {
+        if(side[v] != s) continue;
+        h_to_sub[v] = sub_to_h.size();
+        sub_to_h.push_back(v);
+        sub.vertex_weight.push_back(h.vertex_weight[v]);
+    }
+    sub.num_vertices = sub_to_h.size();
 
-        // If error
-        if(!success) {
-            Formula f2;
-            f2.vars = -1;
-            result.push_back(f2);
+    for(int e = 0; e < h.num_nets; ++e) {
+        int start = sub.pins.size();
+        for(int i = h.net_start[e]; i < h.net_start[e+1]; ++i) {
+            if(h_to_sub[h.pins[i]] != -1) sub.pins.push_back(h_to_sub[h.pins[i]]);
+        }
+
+        if(sub.pins.size() - start < 2) {
+            sub.pins.resize(start);
         } else {
-            Formula f2;
-            f2.vars = divide.vars_2;
-            f2.formula = divide.formula_2;
-            result.push_back(f2);
+            sub.net_start.push_back(sub.pins.size());
+            sub.net_weight.push_back(h.net_weight[e]);
         }
     }
-    return result;
+    sub.num_nets = sub.net_weight.size();
+    sub.buildIncidence();
+
+    return sub;
+}
+
+
+/**
+ * Maps clauses to groups using the multilevel partitioner (same output as findGroupsMappingHelper)
+ * Clauses are partitioned into num_subarrays subarrays, and each num_groups consecutive
+ * subarrays form a group
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - int num_subarrays: number of subarrays
+ * - int num_groups: number of subarrays in each group
+ * - unsigned seed: seed for the partitioner
+ * 
+ * Returns:
+ * - unordered_map<int, int>: map from clause numbers to group numbers
+*/
+unordered_map<int, int> findGroupsMappingMultilevel(int vars, vector<vector<int>>& formula, int num_subarrays, int num_groups, unsigned seed) {
+    Hypergraph h;
+    h.fromFormula(vars, formula);
+
+    MultilevelPartition mp(seed);
+    vector<int> part = mp.partition(h, num_subarrays);
+
+    unordered_map<int, int> mappings;
+    for(int c = 0; c < formula.size(); ++c) {
+        mappings[c+1] = part[c] / num_groups;
+    }
+
+    return mappings;
+}
+
+
+/**
+ * Lists the assignment snapshot files of a solver trace (files starting with "assignments"), in order
+ * 
+ * Params:
+ * - string input_folder: folder with the assignment files (ex: "../minisat/output_assignments/")
+ * - string prefix: only files starting with this are listed
+ * - string suffix: only files ending with this are listed (ex: ".cnf" with an empty prefix lists formulas)
+ * 
+ * Returns:
+ * - vector<string>: sorted filenames (without the folder)
+*/
+vector<string> listSnapshotFiles(string input_folder, string prefix, string suffix) {
+    vector<string> filenames;
+    DIR *dp = opendir(input_folder.c_str());
+    if(dp == nullptr) {
+        cout << "ERROR: could not open " << input_folder << endl;
+        return filenames;
+    }
+    struct dirent *entry;
+    while((entry = readdir(dp))) {
+        string filename = entry->d_name;
+        if(filename.size() < prefix.size() + suffix.size()) continue;
+        if(filename.compare(0, prefix.size(), prefix) != 0) continue;
+        if(filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+        filenames.push_back(filename);
+    }
+    closedir(dp);
+    sort(filenames.begin(), filenames.end());
+    return filenames;
+}
+
+/**
+ * Reads a solver trace (assignment snapshots from the modified minisat, either files starting
+ * with "assignments" in a folder or a binary snapshot log) and finds how often each var is assigned
+ * 
+ * Params:
+ * - string input: folder with the assignment files (ex: "../minisat/output_assignments/") or snapshot log file
+ * - int vars: number of vars
+ * - int& snapshots: returns the number of snapshots read
+ * 
+ * Returns:
+ * - vector<double>: fraction of snapshots each var is assigned in (size vars+1)
+*/
+vector<double> traceVarFrequencies(string input, int vars, int& snapshots) {
+    vector<double> frequencies(vars+1, 0);
+    snapshots = 0;
+
+    if(isSnapshotLog(input)) {
+        SnapshotLog log(input);
+        while(log.next()) {
+            for(int lit : log.trail) {
+                if(abs(lit) <= vars) frequencies[abs(lit)] += 1;
+            }
+            ++snapshots;
+        }
+    } else {
+        for(string filename : listSnapshotFiles(input)) {
+            int propagations = 0;
+            unordered_set<int> assignments = parseAssignmentsFile(input + filename, propagations);
+            for(int lit : assignments) {
+                if(abs(lit) <= vars) frequencies[abs(lit)] += 1;
+            }
+            ++snapshots;
+        }
+    }
+
+    if(snapshots) {
+        for(double& f : frequencies) f /= snapshots;
+    }
+
+    return frequencies;
+}
+
+/**
+ * Places clauses into subarrays so that hot vars (high weight) touch as few subarrays as possible
+ * Uses the multilevel partitioner with each var's net weighted by its trace weight
+ * (vars that never show up keep a small weight, so they still count)
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - const vector<double>& var_weights: weight of each var (ex: from traceVarFrequencies)
+ * - int num_subarrays: number of subarrays
+ * - unsigned seed: seed for the partitioner
+ * 
+ * Returns:
+ * - vector<int>: subarray of each clause (0-indexed clauses)
+*/
+vector<int> placeClausesByTrace(int vars, vector<vector<int>>& formula, const vector<double>& var_weights, int num_subarrays, unsigned seed) {
+    Hypergraph h;
+    h.fromFormula(vars, formula);
+
+    double max_weight = 0;
+    for(double w : var_weights) max_weight = max(max_weight, w);
+    for(int e = 0; e < h.num_nets; ++e) {
+        double w = (max_weight > 0) ? var_weights[h.net_var[e]] / max_weight : 0;
+        h.net_weight[e] = 1 + (int)(100 * w);
+    }
+
+    MultilevelPartition mp(seed);
+    return mp.partition(h, num_subarrays);
+}
+
+/**
+ * Expected number of subarrays (or groups of subarrays) activated per propagation, if the
+ * propagated var is picked with probability proportional to its weight
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - const vector<int>& clause_subarray: subarray of each clause (0-indexed clauses)
+ * - const vector<double>& var_weights: weight of each var
+ * - int subarrays_per_group: 1 to count subarrays, else consecutive subarrays form a group
+ * 
+ * Returns:
+ * - double: expected activations per propagation
+*/
+double expectedActivations(int vars, vector<vector<int>>& formula, const vector<int>& clause_subarray, const vector<double>& var_weights, int subarrays_per_group) {
+    GroupActivation activation(vars, formula, clause_subarray);
+    vector<int> table(activation.num_keys);
+    for(int k = 0; k < table.size(); ++k) table[k] = k / subarrays_per_group;
+
+    vector<vector<int>> per_var;
+    activation.countGroups({table}, &per_var);
+
+    double total = 0, weight = 0;
+    for(int v = 1; v <= vars; ++v) {
+        total += var_weights[v] * per_var[0][v];
+        weight += var_weights[v];
+    }
+
+    return (weight > 0) ? total / weight : 0;
+}
+
+/**
+ * Compares clause placements by expected activations per propagation on a solver trace:
+ * round-robin, multilevel (ignoring the trace), and trace-weighted multilevel
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - string trace_folder: folder with the assignment files from the modified minisat
+ * - int num_subarrays: number of subarrays
+ * - int num_groups: number of subarrays in each group
+*/
+void runTracePlacementExperiment(int vars, vector<vector<int>>& formula, string trace_folder, int num_subarrays, int num_groups) {
+    int snapshots = 0;
+    vector<double> weights = traceVarFrequencies(trace_folder, vars, snapshots);
+    if(snapshots == 0) {
+        cout << "ERROR: no assignment files in " << trace_folder << endl;
+        return;
+    }
+
+    vector<int> round_robin(formula.size());
+    for(int c = 0; c < formula.size(); ++c) round_robin[c] = c % num_subarrays;
+
+    Hypergraph h;
+    h.fromFormula(vars, formula);
+    MultilevelPartition mp;
+    vector<int> multilevel = mp.partition(h, num_subarrays);
+
+    vector<int> traced = placeClausesByTrace(vars, formula, weights, num_subarrays);
+
+    vector<string> names = {"round-robin", "multilevel", "trace-weighted"};
+    vector<vector<int>*> placements = {&round_robin, &multilevel, &traced};
+
+    cout << "Trace: " << snapshots << " snapshots" << endl;
+    cout << "Expected activations per propagation (subarrays, groups of " << num_groups << "):" << endl;
+    for(int i = 0; i < names.size(); ++i) {
+        double subarrays = expectedActivations(vars, formula, *placements[i], weights, 1);
+        double groups = expectedActivations(vars, formula, *placements[i], weights, num_groups);
+        cout << "\t" << names[i] << ": " << subarrays << ", " << groups << endl;
+    }
+    cout << endl;
+}
+
+
+/**
+ * Removes k literals from the formula, saving the answers to vars_2, clauses_2, formula_2
+ * 
+ * Params:
+ * - unordered_set<int> remove: the literals that will be set, thus removing these variables
+ * - bool recurse: if true, then if unit clauses caused by "remove", then will continue to recurse to remove them
+ * - bool renumber: if true, then renumber formula_2 once all removals are done (var_map_2 maps back to old vars)
+ * 
+ * Returns:
+ * - bool: false if error occurs
+*/
+bool DivideFormula::removeKLiterals(unordered_set<int> remove, bool recurse, bool renumber) {
+    // Keep track of a temporary formula (old version)
+    vector<vector<int>> tmp_formula = formula; 
+
+    int tmp_vars = vars;
+
+    // Loop
+    while(remove.size()) {
+        // Clear formula_2
+        formula_2.clear();
+
+        // Set new vars_2
+        vars_2 = tmp_vars - remove.size();
+
+        // Keep track of unit clause variables to satisfy
+        unordered_set<int> unit_clause_vars;
+        unordered_set<int> unit_clause_i;
+
+        // Add remove vars to assignment
+        // for(int lit : remove) {
+        //     cout << "assigned " << lit << endl;
+        // }
+
+        // Iterate through each clause
+        for(int c = 0; c < tmp_formula.size(); ++c) {
+            // Check if this clause is already satisfied
+            bool satisfied = false;
+            for(int l : tmp_formula[c]) {
+                if(remove.count(l)) {
+                    satisfied = true;
+                    break;
+                }
+            }
+            if(satisfied) continue;
+
+            // Else, construct the new clause
+            vector<int> new_clause;
+            for(int l : tmp_formula[c]) {
+                // If negative of this literal in remove set, skip literal
+                if(remove.count(-1*l)) continue;
+
+                // Add literal
+                new_clause.push_back(l);
+            }
+            if(new_clause.empty()) {
+                // If empty clause, that means it is unsatisfiable with this assignment
+                // cout << "ERROR: Clause " << c+1 << " is now not satisfied." << endl;
+                return false;
+            }
+
+            // If unit clause, keep track of it
+            if(new_clause.size() == 1) {
+                // Make sure there's no contradiction
+                if(unit_clause_vars.count(-1*new_clause[0])) {
+                    // cout << "ERROR: Contradiction with variable " << abs(new_clause[0]) << " for unit clauses." << endl;
+                    return false;
+                }
+                // Add
+                unit_clause_vars.insert(new_clause[0]);
+                unit_clause_i.insert(formula_2.size());
+            }
+
+            // Else, can add to formula
+            formula_2.push_back(new_clause);
+
+        }
+
+        // Set clauses
+        clauses_2 = formula_2.size();
+
+        // Mark as assigned
+        for(int l : remove) assignments_made.insert(l);
+
+        // Can now clear remove set
+        remove.clear();
+
+        if(recurse) {
+            // Find vars to remove again
+            for(int clause_i : unit_clause_i) {
+                remove.insert(formula_2[clause_i][0]);
+            }
+            // Formula 2 is now the new temp
+            tmp_formula = formula_2;
+            tmp_vars = vars_2;
+        } else {
+            break;
+        }
+    }
+
+    // Renumber once at the end (assignments_made stays in the original numbering),
+    // which also gives the accurate number of variables
+    vector<int> old_to_new;
+    if(renumber) {
+        vars_2 = renumberFormula(formula_2, old_to_new, var_map_2);
+        return true;
+    }
+
+    // Update number of variables to be accurate
+    old_to_new.assign(vars + 1, 0);
+    vars_2 = 0;
+    for(const vector<int>& c : formula_2) {
+        for(int l : c) {
+            int var = abs(l);
+            if(var >= old_to_new.size()) old_to_new.resize(var + 1, 0);
+            if(old_to_new[var] == 0) {
+                old_to_new[var] = 1;
+                ++vars_2;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * Helper function that given vars to remove, generates all combinations of literals
+ * Ex: Input = {1, 2}, Output = {{-1, -2}, {-1, 2}, {1, -2}, {1, 2}}
+ * 
+ * Params:
+ * - unordered_set<int> remove_vars: the vars to remove
+ * 
+ * Returns:
+ * - vector<unordered_set<int>>: vector of literal combos
+*/
+vector<unordered_set<int>> generateLitsCombos(unordered_set<int> remove_vars) {
+    // Convert remove vars to vector
+    vector<int> remove_v;
+    for(int rv : remove_vars) remove_v.push_back(rv);
+
+    vector<unordered_set<int>> solution;
+    unordered_set<int> curr;
+    generateLitsCombosHelper(solution, remove_v, curr, 0);
+    return solution;
+}
+void generateLitsCombosHelper(vector<unordered_set<int>>& answer, vector<int> remove_vars, unordered_set<int> curr, int i) {
+    if(curr.size() == remove_vars.size()) {
+        answer.push_back(curr);
+        return;
+    }
+
+    unordered_set<int> curr_2 = curr;
+    curr.insert(remove_vars[i]);
+    curr_2.insert(-1*remove_vars[i]);
+
+    // Recurse
+    generateLitsCombosHelper(answer, remove_vars, curr, i+1);
+    generateLitsCombosHelper(answer, remove_vars, curr_2, i+1);
+}
+
+
+/**
+ * Given a formula and a number k, returns the k most frequently appearing variables, in order
+ * 
+ * Params:
+ * - int vars: the number of variables
+ * - vector<vector<int>> formula: the SAT formula
+ * - int k: the number of vars to return
+ * 
+ * Returns:
+ * - vector<int>: vars in order by occurrences
+*/
+vector<int> kMostOccurring(int vars, vector<vector<int>>& formula, int k) {
+    // Frequency of each var
+    vector<int> var_freqs(formulaMaxVar(formula, vars) + 1, 0);
+    for(const vector<int>& c : formula) {
+        for(int l : c) {
+            ++var_freqs[abs(l)];
+        }
+    }
+
+    // <occurrences, variable> of vars that occur, largest first
+    vector<pair<int, int>> order;
+    for(int v = 1; v < var_freqs.size(); ++v) {
+        if(var_freqs[v]) order.push_back(make_pair(var_freqs[v], v));
+    }
+    k = min(k, (int)order.size());
+    partial_sort(order.begin(), order.begin() + k, order.end(), greater<pair<int, int>>());
+
+    vector<int> solution;
+    for(int i = 0; i < k; ++i) solution.push_back(order[i].second);
+    return solution;
+}
+
+/**
+ * Runs divide and conquer experiment
+ * Combos are visited in Gray code order on a shared trail (see CubeGenerator::enumerateSplits), 
+ * with the first vars fixed per task so tasks run in parallel
+ * 
+ * Params:
+ * - Circuit c: includes information about the SAT formula
+ * - unordered_set<int> remove_vars: the variables to remove (tries all literal combos)
+ * - bool show_stats: prints out stats
+ * - bool print: if true, prints info about each lit combo
+ * - int num_threads: 0 = all hardware threads
+*/
+void runDivideExperiment(Circuit c, unordered_set<int> remove_vars, bool show_stats, bool print, int num_threads) {
+    // Keep track of stats
+    int successes = 0;
+    long long total_vars = 0;
+    long long total_clauses = 0;
+    int min_vars = INT_MAX;
+    int min_clauses = INT_MAX;
+
+    // Keep track of vars in order
+    vector<int> remove_vars_order;
+    for(int rv : remove_vars) remove_vars_order.push_back(rv);
+    sort(remove_vars_order.begin(), remove_vars_order.end());
+    int k = remove_vars_order.size();
+
+    // Fix enough leading vars to give every thread a few tasks
+    int threads = threadsToUse(num_threads);
+    int fixed = 0;
+    while(fixed < k && (1 << fixed) < 4 * threads) ++fixed;
+    int num_tasks = 1 << fixed;
+
+    // Printed rows are buffered per task and printed in task order after the run, so the output
+    // doesn't depend on thread timing (within a task, combos are in Gray code order)
+    vector<string> task_output(print ? num_tasks : 0);
+
+    atomic<int> next(0);
+    mutex stats_mutex;
+    parallelFor(threads, threads, [&](int) {
+        CubeGenerator generator(c.vars, c.formula);
+
+        int local_successes = 0;
+        long long local_vars = 0, local_clauses = 0;
+        int local_min_vars = INT_MAX, local_min_clauses = INT_MAX;
+
+        for(int task = next++; task < num_tasks; task = next++) {
+            ostringstream out;
+            generator.enumerateSplits(remove_vars_order, fixed, task, [&](const vector<int>& lits, bool success) {
+                if(print) {
+                    out << "Removed Lits: ";
+                    for(int l : lits) out << l << " ";
+                    out << endl;
+                    if(success) {
+                        out << "\tVars Remaining: " << generator.vars_remaining << "  (" << generator.vars_remaining * 100.0 / c.vars << "%)" << endl;
+                        out << "\tClauses Remaining: " << generator.clauses_remaining << "  (" << generator.clauses_remaining * 100.0 / c.clauses << "%)" << endl;
+                    } else {
+                        out << "\tFAILED" << endl;
+                    }
+                }
+                if(!success) return;
+
+                // Track stats
+                ++local_successes;
+                local_vars += generator.vars_remaining;
+                local_clauses += generator.clauses_remaining;
+                local_min_vars = min(local_min_vars, generator.vars_remaining);
+                local_min_clauses = min(local_min_clauses, generator.clauses_remaining);
+            });
+            if(print) task_output[task] = out.str();
+        }
+
+        lock_guard<mutex> lock(stats_mutex);
+        successes += local_successes;
+        total_vars += local_vars;
+        total_clauses += local_clauses;
+        min_vars = min(min_vars, local_min_vars);
+        min_clauses = min(min_clauses, local_min_clauses);
+    });
+
+    for(const string& rows : task_output) cout << rows;
+
+    if(show_stats) {
+        int avg_vars = (total_vars * 1.0 / successes);
+        int avg_clauses = (total_clauses * 1.0 / successes);
+
+        cout << endl << "Successes: " << successes << endl;
+        cout << "\nAvg Vars Remaining: " << avg_vars << endl;
+        cout << "\tPercent: " << avg_vars * 100.0 / c.vars << "%" << endl;
+        cout << "Avg Clauses Remaining: " << avg_clauses << endl;
+        cout << "\tPercent: " << avg_clauses * 100.0 / c.clauses << "%" << endl;
+        cout << "\nMin Vars Remaining: " << min_vars << endl;
+        cout << "\tPercent: " << min_vars * 100.0 / c.vars << "%" << endl;
+        cout << "Min Clauses Remaining: " << min_clauses << endl;
+        cout << "\tPercent: " << min_clauses * 100.0 / c.clauses << "%\n\n";
+    }
+}
+
+/**
+ * Same as above, but only divides using one variable
+ * Returns a vector of size 2 of Circuit objects after dividing
+ * 
+ * Params:
+ * - Formula f: includes information about the SAT formula
+ * - int remove_var: var to remove
+ * 
+ * Returns:
+ * - vector<Formula>: size 2 where first Formula is after removing negative literal, second one after removing positive literal
+ *   - if either causes error, will be a Formula object with f.vars set to -1
+*/
+vector<Formula> runDivideExperimentSingleVar(Formula f, int remove_var) {
+    // Result
+    vector<Formula> result;
+
+    // Iterate through each combination
+    vector<int> order = {-1 * abs(remove_var), abs(remove_var)};
+    for(int curr_var : order) {
+        // Remove the var
+        DivideFormula divide(f.vars, f.formula);
+        unordered_set<int> curr = {curr_var};
+        bool success = divide.removeKLiterals(curr, true, false);
+
+        // If error
+        if(!success) {
+            Formula f2;
+            f2.vars = -1;
+            result.push_back(f2);
+        } else {
+            Formula f2;
+            f2.vars = divide.vars_2;
+            f2.formula = divide.formula_2;
+            result.push_back(f2);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns k random variables given a number of variables
+ * 
+ * Params:
+ * - int vars: number of variables
+ * - int k: size of set to return
+ * 
+ * Returns:
+ * - unordered_set<int>: the k random variables
+*/
+unordered_set<int> kRandomVariables(int vars, int k) {
+    unordered_set<int> result;
+
+    while(result.size() != k) {
+        // Pick random variable
+        int r = (rand() % vars) + 1;
+
+        result.insert(r);
+    }
+
+    return result;
+}
+
+/**
+ * Creates contiguous groups by number of unique vars in group
+ * 
+ * Params:
+ * - max_vars: maximum number of unique variables in a group
+ * 
+ * Returns:
+ * - int: number of groups made
+ * - group_to_clauses and clause_to_group class variables get set
+*/
+int ContiguousPartition::createPartitionsBySize(int max_size) {
+    ContiguousGrouper grouper(vars, max_size);
+
+    // Iterate through each clause
+    for(int c = 0; c < clauses; ++c) {
+        int curr_clause = c+1;
+
+        // Assign clause
+        int group = grouper.addClause(formula[c]);
+        group_to_clauses[group].insert(curr_clause);
+        clause_to_group[curr_clause] = group;
+    }
+
+    // Return number of groups
+    return grouper.numGroups();
+}
+
+/**
+ * Evaluates groupings by seeing what number of vars activate 1 group, 2 groups, ...
+ * and prints information about these results
+*/
+void ContiguousPartition::evaluateGroupings() {
+    // Create map for mappings
+    unordered_map<int, int> mappings;
+    for(int i = 1; i < clauses; ++i) {
+        mappings[i] = clause_to_group[i];
+    }
+    unordered_map<int, set<int>> results = runGroupsExperiment(vars, formula, mappings);
+    
+    // printGroupsResults(results, group_to_clauses.size());
+
+    int max_i = group_to_clauses.size();
+    while(results[max_i].size() == 0) {
+        --max_i;
+    }
+
+    cout << "Number of Groups: Number of Variables that Activate That Amount" << endl;
+    for(int i = 0; i <= max_i; ++i) {
+        // cout << i << ": " ;
+        cout << results[i].size() << endl;
+    }
+}
+
+
+/**
+ * Adds the next clause to the current group, or starts a new group if the clause would
+ * take the group over max_vars unique vars (clauses with more than max_vars vars get their own group)
+ * 
+ * Params:
+ * - const vector<int>& clause: the clause
+ * 
+ * Returns:
+ * - int: group of the clause
+*/
+int ContiguousGrouper::addClause(const vector<int>& clause) {
+    ++clause_count;
+
+    // Count the clause's vars that aren't in the current group yet
+    int new_vars = 0, clause_vars = 0;
+    for(int lit : clause) {
+        int var = abs(lit);
+        if(var >= clause_stamp.size()) {
+            clause_stamp.resize(2*var + 1, 0);
+            group_stamp.resize(2*var + 1, 0);
+            var_groups.resize(2*var + 1, 0);
+        }
+        if(clause_stamp[var] == clause_count) continue;
+        clause_stamp[var] = clause_count;
+        ++clause_vars;
+        if(group_stamp[var] != curr_group + 1) ++new_vars;
+    }
+
+    // Start a new group if needed (groups are stamped with group + 1, so nothing is cleared)
+    if(group_vars > 0 && (group_vars + new_vars > max_vars || clause_vars > max_vars || group_full)) {
+        ++curr_group;
+        group_vars = 0;
+        new_vars = clause_vars;
+    }
+    group_full = (clause_vars > max_vars);
+
+    for(int lit : clause) {
+        int var = abs(lit);
+        if(group_stamp[var] == curr_group + 1) continue;
+        group_stamp[var] = curr_group + 1;
+        ++var_groups[var];
+    }
+    group_vars += new_vars;
+
+    return curr_group;
+}
+
+/**
+ * Returns number of groups made so far
+*/
+int ContiguousGrouper::numGroups() {
+    return (clause_count == 0) ? 0 : curr_group + 1;
+}
+
+
+/**
+ * Streaming version of ContiguousPartition::createPartitionsBySize: reads clauses one at a time,
+ * so only the current group's vars are kept (the formula is never stored)
+ * Writes each group's boundaries to a file, one line per group: group first_clause last_clause num_vars
+ * 
+ * Params:
+ * - const string& cnf_file: the SAT formula file
+ * - int max_vars: maximum number of unique variables in a group
+ * - const string& output_file: file for the group boundaries
+ * - vector<int>& histogram: returns [i] = number of vars that activate i groups
+ * - bool print: if true, prints the histogram like evaluateGroupings()
+ * 
+ * Returns:
+ * - int: number of groups made
+*/
+int streamContiguousPartition(const string& cnf_file, int max_vars, const string& output_file, vector<int>& histogram, bool print) {
+    CNFReader reader(cnf_file);
+    CNFWriter writer(output_file);
+    if(!reader.isOpen() || !writer.isOpen()) return 0;
+
+    writer.writeString("c Contiguous groups (max " + to_string(max_vars) + " vars): group first_clause last_clause num_vars\n");
+
+    // Read the first clause, so the header (number of vars) is known
+    vector<int> clause;
+    bool more = reader.nextClause(clause);
+    ContiguousGrouper grouper(reader.vars, max_vars);
+    int group_start = 1, prev_group = 0, prev_group_vars = 0;
+    int max_var = reader.vars;
+
+    auto writeGroup = [&](int group, int first, int last, int num_vars) {
+        writer.writeInt(group);
+        writer.writeChar(' ');
+        writer.writeInt(first);
+        writer.writeChar(' ');
+        writer.writeInt(last);
+        writer.writeChar(' ');
+        writer.writeInt(num_vars);
+        writer.writeChar('\n');
+    };
+
+    for(; more; more = reader.nextClause(clause)) {
+        for(int lit : clause) max_var = max(max_var, abs(lit));
+
+        int group = grouper.addClause(clause);
+        if(group != prev_group) {
+            writeGroup(prev_group, group_start, grouper.clause_count - 1, prev_group_vars);
+            group_start = grouper.clause_count;
+            prev_group = group;
+        }
+        prev_group_vars = grouper.group_vars;
+    }
+    if(reader.malformed) return 0;
+    if(grouper.clause_count > 0) writeGroup(prev_group, group_start, grouper.clause_count, prev_group_vars);
+
+    // Vars from the header that never showed up activate 0 groups
+    histogram.assign(grouper.numGroups() + 1, 0);
+    for(int v = 1; v <= max_var; ++v) {
+        int groups = (v < grouper.var_groups.size()) ? grouper.var_groups[v] : 0;
+        ++histogram[groups];
+    }
+
+    if(print) {
+        int max_i = histogram.size() - 1;
+        while(max_i > 0 && histogram[max_i] == 0) --max_i;
+
+        cout << "Number of Groups: Number of Variables that Activate That Amount" << endl;
+        for(int i = 0; i <= max_i; ++i) cout << histogram[i] << endl;
+    }
+
+    return grouper.numGroups();
+}
+
+/**
+ * Given a variable and a formula, figure out where it occurs in the formula.
+ * Specifically, the mean clause number, and the standard deviation, the min clause num, max clause num
+ * 
+ * Params:
+ * - int var: the variable to focus on
+ * - vector<vector<int>> formula: the SAT formula
+ * 
+ * Returns:
+ * - prints mean, standard deviation, min clause, max clause
+*/
+void findVarMeanAndSDClause(int var, vector<vector<int>>& formula) {
+    // Keep track of the clauses this var occurs in
+    unordered_set<int> clauses;
+    // Keep track of the sum
+    int sum = 0;
+
+    // Keep track of min and max clauses
+    int min_clause = INT_MAX;
+    int max_clause = INT_MIN;
+
+    // Iterate through each clause
+    for(int i = 0; i < formula.size(); ++i) {
+        int c = i+1;
+        for(int lit : formula[i]) {
+            // If var in formula
+            if(abs(lit) == var) {
+                min_clause = min(min_clause, c);
+                max_clause = max(max_clause, c);
+
+                sum += c;
+                clauses.insert(c);
+                break;
+            }
+        }
+    }
+
+    // Find mean
+    float mean = (sum * 1.0) / (clauses.size() * 1.0);
+
+    // Find standard deviation
+    float tmp = 0;
+    for(int c : clauses) {
+        tmp += (c - mean) * (c - mean);
+    }
+    float sd = pow((tmp / (clauses.size() - 1.0)), 0.5);
+    
+
+    // Print
+    cout << "Var " << var << endl;
+    cout << "\tMean: " << mean << endl;
+    cout << "\tSD: " << sd << endl;
+    cout << "\tMin: " << min_clause << "\t\tMax: " << max_clause << endl;
+}
+
+/**
+ * Identical to previous function, but finds stats for all variables
+*/
+void findAllMeanAndSdClauses(int total_vars, vector<vector<int>>& formula) {
+    // Keep track of the clauses each var occurs in
+    unordered_map<int, set<int>> var_to_clauses;
+
+    // Maintain min clause and max clause
+    unordered_map<int, int> var_to_min_clause;
+    unordered_map<int, int> var_to_max_clause;
+
+    // Keep track of sum of clauses for each var
+    unordered_map<int, int> var_to_sum;
+
+    // Fill in values
+    for(int i = 0; i < formula.size(); ++i) {
+        int c = i+1;
+        for(int lit : formula[i]) {
+            int v = abs(lit);
+            var_to_clauses[v].insert(c);
+
+            if(var_to_min_clause.count(v) == 0 || var_to_min_clause[v] > c) {
+                var_to_min_clause[v] = c;
+            }
+
+            if(var_to_max_clause.count(v) == 0 || var_to_max_clause[v] < c) {
+                var_to_max_clause[v] = c;
+            }
+
+            var_to_sum[v] += c;
+        }
+    }
+
+    // Calculate and print out stats for each var
+    for(int v = 1; v <= total_vars; ++v) {
+        // Find mean
+        float mean = (var_to_sum[v] * 1.0) / (var_to_clauses[v].size() * 1.0);
+
+        // Find standard deviation
+        float tmp = 0;
+        for(int c : var_to_clauses[v]) {
+            tmp += (c - mean) * (c - mean);
+        }
+        float sd = pow((tmp / (var_to_clauses[v].size() - 1.0)), 0.5);
+        
+
+        // Print
+        cout << "Var " << v << endl;
+        cout << "\tMean: " << mean << endl;
+        cout << "\tSD: " << sd << endl;
+        cout << "\tMin: " << var_to_min_clause[v] << "\t\tMax: " << var_to_max_clause[v] << endl;
+    }
+}
+
+
+/**
+ * Largest var in the formula (formulas divided without renumbering keep their original var numbers)
+ * 
+ * Params:
+ * - const vector<vector<int>>& formula: the SAT formula
+ * - int vars: the number of variables
+ * 
+ * Returns:
+ * - int: max(vars, largest var in formula)
+*/
+int formulaMaxVar(const vector<vector<int>>& formula, int vars) {
+    int max_var = max(vars, 0);
+    for(const vector<int>& c : formula) {
+        for(int l : c) max_var = max(max_var, abs(l));
+    }
+    return max_var;
+}
+
+/**
+ * Jeroslow-Wang clause weights
+ * 
+ * Params:
+ * - int max_size: largest clause size
+ * 
+ * Returns:
+ * - vector<double>: [s] is 2^-s, for s = 0 .. max_size
+*/
+vector<double> jwWeights(int max_size) {
+    vector<double> weight(max_size + 1);
+    for(int s = 0; s <= max_size; ++s) weight[s] = ldexp(1.0, -s);
+    return weight;
+}
+
+/**
+ * Uses most occurred heuristic to determine best var to remove
+ * 
+ * Params:
+ * - vector<vector<int>> formula: the SAT formula
+ * - int vars: the number of variables
+ * 
+ * Returns:
+ * - int: the most occurring var
+*/
+int heurFindMostOccurVar(vector<vector<int>>& formula, int vars) {
+    vector<int> occur(formulaMaxVar(formula, vars) + 1, 0);
+    int max_var = 0, max_occur = -1;
+    for(const vector<int>& c : formula) {
+        for(int lit : c) {
+            int var = abs(lit);
+            ++occur[var];
+
+            // Update
+            if(max_occur < occur[var]) {
+                max_occur = occur[var];
+                max_var = var;
+            }
+        }
+    }
+    return max_var;
+}
+
+/**
+ * Uses most occurred heuristic to determine best var to remove
+ * 
+ * Params:
+ * - vector<vector<int>> formula: the SAT formula
+ * - int vars: the number of variables
+ * 
+ * Returns:
+ * - int: the most occurring var
+*/
+int heurFindMostOccurLit(vector<vector<int>>& formula, int vars) {
+    // occur[2v] is lit v, occur[2v+1] is lit -v
+    vector<int> occur(2*(formulaMaxVar(formula, vars) + 1), 0);
+    int max_lit = 0, max_occur = -1;
+    for(const vector<int>& c : formula) {
+        for(int lit : c) {
+            int i = 2*abs(lit) + (lit < 0);
+            ++occur[i];
+
+            // Update
+            if(max_occur < occur[i]) {
+                max_occur = occur[i];
+                max_lit = lit;
+            }
+        }
+    }
+    return abs(max_lit);
+}
+
+
+/**
+ * Uses Jeroslow Wang Heuristic to determine best var
+ * 
+ * Params:
+ * - vector<vector<int>> formula: the SAT formula
+ * - int vars: the number of variables
+ * 
+ * Returns:
+ * - int: the var to remove
+*/
+int heurFindJeroslowWang(vector<vector<int>>& formula, int vars) {
+    double max_score = INT_MIN;
+    int lit_with_max_score = -1;
+
+    // 2^-size of each clause size
+    int max_size = 0;
+    for(const vector<int>& c : formula) max_size = max(max_size, (int)c.size());
+    vector<double> weight = jwWeights(max_size);
+
+    // Keep track of scores (score[2v] is lit v, score[2v+1] is lit -v)
+    vector<double> score(2*(formulaMaxVar(formula, vars) + 1), 0);
+    for(const vector<int>& c : formula) {
+        double clause_score = weight[c.size()];
+
+        for(int l : c) {
+            // Update score
+            int i = 2*abs(l) + (l < 0);
+            score[i] += clause_score;
+
+            if(max_score < score[i]) {
+                max_score = score[i];
+                lit_with_max_score = l;
+            }
+        }
+    }
+
+
+    // Return variable with max score
+    return abs(lit_with_max_score); 
+}
+
+/**
+ * Uses maximum occurrences in clauses of minimum size heuristic
+*/
+int heurFindMOM(vector<vector<int>>& formula, int vars) {
+    int min_size = INT_MAX;
+    for(const vector<int>& c : formula) min_size = min(min_size, (int)c.size());
+
+    // Occurrences in minimum size clauses (occur[2v] is lit v, occur[2v+1] is lit -v)
+    vector<int> occur(2*(formulaMaxVar(formula, vars) + 1), 0);
+    int most_occurrences = INT_MIN;
+    int lit_with_most = -1;
+    for(const vector<int>& c : formula) {
+        if(c.size() != min_size) continue;
+        for(int l : c) {
+            int i = 2*abs(l) + (l < 0);
+            ++occur[i];
+
+            if(most_occurrences < occur[i]) {
+                most_occurrences = occur[i];
+                lit_with_most = l;
+            }
+        }
+    }
+
+    return abs(lit_with_most);
+}
+
+
+/**
+ * Builds occurrence lists and watches, then propagates the unit clauses of the formula
+ * 
+ * Params:
+ * - int v: number of vars
+ * - vector<vector<int>>& f: the SAT formula
+*/
+CubeGenerator::CubeGenerator(int v, vector<vector<int>>& f) : formula(f) {
+    vars = v;
+    clauses = f.size();
+    debug = false;
+    failed = 0;
+    qhead = 0;
+    root_conflict = false;
+    score_mode = -1;
+    mom_max_size = 4;
+    lookahead_candidates = 20;
+    mom_size = 0;
+    stamp = 0;
+
+    value.assign(vars+1, 0);
+    sat_count.assign(clauses, 0);
+    active.assign(vars+1, 0);
+    watches.assign(2*(vars+1), vector<int>());
+    watch_pos.assign(2*clauses, 0);
+
+    // Occurrence lists of each literal
+    buildOccurrenceIndex(formula, vars, true, occ_start, occ);
+    for(int var = 1; var <= vars; ++var) active[var] = occ_start[2*var+2] - occ_start[2*var];
+
+    clauses_remaining = clauses;
+    vars_remaining = 0;
+    for(int var = 1; var <= vars; ++var) {
+        if(active[var]) ++vars_remaining;
+    }
+
+    // Watch the first two literals (clause literal order is never changed)
+    vector<int> units;
+    for(int c = 0; c < clauses; ++c) {
+        if(formula[c].empty()) {
+            root_conflict = true;
+        } else if(formula[c].size() == 1) {
+            units.push_back(formula[c][0]);
+        } else {
+            watch_pos[2*c] = 0;
+            watch_pos[2*c+1] = 1;
+            watches[litIndex(formula[c][0])].push_back(c);
+            watches[litIndex(formula[c][1])].push_back(c);
+        }
+    }
+
+    // Root level units
+    for(int l : units) {
+        if(root_conflict) break;
+        if(value[abs(l)] == 0) assign(l);
+        else if(litValue(l) < 0) root_conflict = true;
+    }
+    if(!root_conflict && !propagate()) root_conflict = true;
+}
+
+/**
+ * Makes lit true and updates the remaining vars and clauses counters
+*/
+void CubeGenerator::assign(int lit) {
+    int var = abs(lit);
+    if(score_mode >= 0) removeTouchedScores(var);
+    value[var] = lit > 0 ? 1 : -1;
+    trail.push_back(lit);
+    if(active[var] > 0) --vars_remaining;
+
+    int li = litIndex(lit);
+    for(int i = occ_start[li]; i < occ_start[li+1]; ++i) {
+        int c = occ[i];
+        if(sat_count[c]++ > 0) continue;
+
+        // Clause is now satisfied
+        --clauses_remaining;
+        for(int l : formula[c]) {
+            int u = abs(l);
+            if(--active[u] == 0 && value[u] == 0) --vars_remaining;
+        }
+    }
+
+    if(score_mode >= 0) addTouchedScores(var, -1);
+}
+
+/**
+ * Undoes assign(lit), in reverse order
+*/
+void CubeGenerator::unassign(int lit) {
+    int var = abs(lit);
+    if(score_mode >= 0) removeTouchedScores(var);
+
+    int li = litIndex(lit);
+    for(int i = occ_start[li+1] - 1; i >= occ_start[li]; --i) {
+        int c = occ[i];
+        if(--sat_count[c] > 0) continue;
+
+        ++clauses_remaining;
+        for(int l : formula[c]) {
+            int u = abs(l);
+            if(active[u]++ == 0 && value[u] == 0) ++vars_remaining;
+        }
+    }
+
+    value[var] = 0;
+    if(active[var] > 0) ++vars_remaining;
+
+    if(score_mode >= 0) addTouchedScores(var, 1);
+}
+
+/**
+ * Starts keeping heuristic scores of the reduced formula up to date, so pickVar() reads the best var from
+ * a heap instead of scanning the formula. Scores are per literal (occurrences, Jeroslow-Wang with 2^-size 
+ * weights, and occurrences in clauses of each small size for MOM), and each assignment only updates 
+ * the clauses of its var
+ * 
+ * Params:
+ * - string heur: heuristic served by the heap (see pickVar)
+*/
+void CubeGenerator::trackScores(string heur) {
+    if(heur == "jeroslow-wang" || heur == "lookahead") score_mode = 2;
+    else if(heur == "mom") score_mode = 3;
+    else if(heur == "most_occur_lit") score_mode = 1;
+    else score_mode = 0;
+
+    int max_size = 0;
+    for(const vector<int>& c : formula) max_size = max(max_size, (int)c.size());
+    jw_weight = jwWeights(max_size);
+
+    occ_score.assign(2*(vars+1), 0);
+    jw_score.assign(2*(vars+1), 0);
+    mom_count.assign(mom_max_size+1, vector<int>(2*(vars+1), 0));
+    size_count.assign(max_size+1, 0);
+    touch_stamp.assign(clauses, 0);
+
+    // Scores from the current assignment
+    free_count.assign(clauses, 0);
+    for(int c = 0; c < clauses; ++c) {
+        for(int l : formula[c]) {
+            if(value[abs(l)] == 0) ++free_count[c];
+        }
+        if(sat_count[c] == 0) updateScores(c, 1);
+    }
+
+    mom_size = minClauseSize();
+    buildScoreHeap();
+}
+
+/**
+ * Adds (sign = 1) or removes (sign = -1) the score contributions of unsatisfied clause c
+*/
+void CubeGenerator::updateScores(int c, int sign) {
+    int size = free_count[c];
+    size_count[size] += sign;
+    double w = jw_weight[size];
+    bool mom = size <= mom_max_size;
+
+    for(int l : formula[c]) {
+        if(value[abs(l)] != 0) continue;
+        int li = litIndex(l);
+        occ_score[li] += sign;
+        jw_score[li] += sign * w;
+        if(mom) mom_count[size][li] += sign;
+    }
+}
+
+/**
+ * Before var changes value: collects the clauses of var and removes the contributions of unsatisfied ones
+*/
+void CubeGenerator::removeTouchedScores(int var) {
+    ++stamp;
+    touched.clear();
+    for(int li = 2*var; li <= 2*var+1; ++li) {
+        for(int i = occ_start[li]; i < occ_start[li+1]; ++i) {
+            int c = occ[i];
+            if(touch_stamp[c] == stamp) continue;
+            touch_stamp[c] = stamp;
+            touched.push_back(c);
+            if(sat_count[c] == 0) updateScores(c, -1);
+        }
+    }
+}
+
+/**
+ * After var changes value: updates the free literal counts (delta = -1 when assigned, 1 when unassigned), 
+ * adds back the contributions of unsatisfied clauses, and updates the heap
+*/
+void CubeGenerator::addTouchedScores(int var, int delta) {
+    for(int li = 2*var; li <= 2*var+1; ++li) {
+        for(int i = occ_start[li]; i < occ_start[li+1]; ++i) free_count[occ[i]] += delta;
+    }
+    for(int c : touched) {
+        if(sat_count[c] == 0) updateScores(c, 1);
+    }
+
+    // Assigned vars leave the heap
+    bool literal_items = score_mode != 0;
+    for(int item : {literal_items ? 2*var : var, literal_items ? 2*var+1 : -1}) {
+        if(item < 0) continue;
+        if(delta < 0 && score_heap.contains(item)) score_heap.remove(item);
+        else if(delta > 0 && !score_heap.contains(item)) score_heap.insert(item, scoreKey(item));
+    }
+
+    for(int c : touched) {
+        for(int l : formula[c]) {
+            if(value[abs(l)] != 0) continue;
+            int item = literal_items ? litIndex(l) : abs(l);
+            score_heap.update(item, scoreKey(item));
+        }
+    }
+}
+
+/**
+ * Heap key of an item (a var for most occurring var, otherwise a literal index)
+*/
+double CubeGenerator::scoreKey(int item) {
+    if(score_mode == 0) return occ_score[2*item] + occ_score[2*item+1];
+    if(score_mode == 1) return occ_score[item];
+    if(score_mode == 2) return jw_score[item];
+    return (mom_size >= 1 && mom_size <= mom_max_size) ? mom_count[mom_size][item] : 0;
+}
+
+/**
+ * Puts every unassigned var (or literal) in the heap with its current key
+*/
+void CubeGenerator::buildScoreHeap() {
+    score_heap = IndexedHeap(2*(vars+1));
+    for(int v = 1; v <= vars; ++v) {
+        if(value[v] != 0) continue;
+        if(score_mode == 0) {
+            score_heap.insert(v, scoreKey(v));
+        } else {
+            score_heap.insert(2*v, scoreKey(2*v));
+            score_heap.insert(2*v+1, scoreKey(2*v+1));
+        }
+    }
+}
+
+/**
+ * Size of the smallest unsatisfied clause (0 if every clause is satisfied), needs trackScores()
+*/
+int CubeGenerator::minClauseSize() {
+    for(int size = 1; size < size_count.size(); ++size) {
+        if(size_count[size]) return size;
+    }
+    return 0;
+}
+
+/**
+ * Best k vars of the tracked heuristic, best first (needs trackScores())
+*/
+vector<int> CubeGenerator::topVars(int k) {
+    if(score_mode == 3 && minClauseSize() != mom_size) {
+        mom_size = minClauseSize();
+        buildScoreHeap();
+    }
+
+    vector<int> result;
+    vector<char> seen(vars+1, 0);
+    int want = (score_mode == 0) ? k : 2*k;
+    for(int item : score_heap.topK(want)) {
+        int var = (score_mode == 0) ? item : item / 2;
+        if(seen[var] || result.size() == k) continue;
+        seen[var] = 1;
+        result.push_back(var);
+    }
+    return result;
+}
+
+/**
+ * Unit propagation with two watched literals
+ * 
+ * Returns:
+ * - bool: false if there is a conflict
+*/
+bool CubeGenerator::propagate() {
+    while(qhead < trail.size()) {
+        int false_lit = -trail[qhead++];
+        vector<int>& list = watches[litIndex(false_lit)];
+
+        int j = 0;
+        for(int i = 0; i < list.size(); ++i) {
+            int c = list[i];
+            const vector<int>& lits = formula[c];
+            int w = lits[watch_pos[2*c]] == false_lit ? 0 : 1;
+            int other = lits[watch_pos[2*c + 1-w]];
+
+            // Clause already satisfied by the other watch
+            if(litValue(other) > 0) {
+                list[j++] = c;
+                continue;
+            }
+
+            // Look for a new literal to watch
+            int found = -1;
+            for(int k = 0; k < lits.size(); ++k) {
+                if(k == watch_pos[2*c] || k == watch_pos[2*c+1]) continue;
+                if(litValue(lits[k]) >= 0) {
+                    found = k;
+                    break;
+                }
+            }
+            if(found != -1) {
+                watch_pos[2*c + w] = found;
+                watches[litIndex(lits[found])].push_back(c);
+                continue;
+            }
+
+            // Unit or conflict
+            list[j++] = c;
+            if(litValue(other) < 0) {
+                for(++i; i < list.size(); ++i) list[j++] = list[i];
+                list.resize(j);
+                return false;
+            }
+            assign(other);
+        }
+        list.resize(j);
+    }
+    return true;
+}
+
+/**
+ * Opens a new level, makes lit true and propagates
+ * 
+ * Params:
+ * - int lit: the literal to assume
+ * 
+ * Returns:
+ * - bool: false if there is a conflict (the level is still open, call undo())
+*/
+bool CubeGenerator::assume(int lit) {
+    trail_lim.push_back(trail.size());
+    decisions.push_back(lit);
+
+    int var = abs(lit);
+    if(value[var] != 0) return litValue(lit) > 0;
+    assign(lit);
+    return propagate();
+}
+
+/**
+ * Undoes the last level opened by assume()
+*/
+void CubeGenerator::undo() {
+    int lim = trail_lim.back();
+    trail_lim.pop_back();
+    decisions.pop_back();
+
+    for(int i = trail.size() - 1; i >= lim; --i) unassign(trail[i]);
+    trail.resize(lim);
+    qhead = lim;
+}
+
+/**
+ * Picks the var to split on with the same heuristics as divideAndConquerHeur, evaluated on the current 
+ * reduced formula. Uses the score heap when trackScores() was called for heur (ties go to the smaller 
+ * var), otherwise scans the formula (satisfied clauses and false literals are skipped, so ties break 
+ * like the heurFind* functions)
+ * 
+ * Params:
+ * - string heur: "jeroslow-wang", "mom", "most_occur_lit", "lookahead" (see pickVarLookahead), 
+ *     or (default) most occurring var
+ * 
+ * Returns:
+ * - int: the var to split on (0 if no clauses remain, -1 if lookahead found a conflict)
+*/
+int CubeGenerator::pickVar(string heur) {
+    if(clauses_remaining == 0) return 0;
+    if(heur == "lookahead") return pickVarLookahead();
+
+    int mode = (heur == "jeroslow-wang") ? 2 : (heur == "mom") ? 3 : (heur == "most_occur_lit") ? 1 : 0;
+    if(mode != score_mode || (mode == 3 && minClauseSize() > mom_max_size)) return pickVarScan(heur);
+
+    vector<int> best = topVars(1);
+    return best.empty() ? 0 : best[0];
+}
+
+/**
+ * Scanning version of pickVar()
+*/
+int CubeGenerator::pickVarScan(string heur) {
+    // Size of the reduced clause
+    auto reducedSize = [&](int c) {
+        int size = 0;
+        for(int l : formula[c]) {
+            if(value[abs(l)] == 0) ++size;
+        }
+        return size;
+    };
+
+    int best = 0;
+    if(heur == "jeroslow-wang") {
+        vector<double> score(2*(vars+1), 0);
+        double max_score = INT_MIN;
+        for(int c = 0; c < clauses; ++c) {
+            if(sat_count[c]) continue;
+            double clause_score = 1.0 / pow(2, reducedSize(c));
+            for(int l : formula[c]) {
+                if(value[abs(l)] != 0) continue;
+                score[litIndex(l)] += clause_score;
+                if(max_score < score[litIndex(l)]) {
+                    max_score = score[litIndex(l)];
+                    best = abs(l);
+                }
+            }
+        }
+    } else if(heur == "mom") {
+        int min_size = INT_MAX;
+        for(int c = 0; c < clauses; ++c) {
+            if(!sat_count[c]) min_size = min(min_size, reducedSize(c));
+        }
+        vector<int> occur(2*(vars+1), 0);
+        int most_occurrences = INT_MIN;
+        for(int c = 0; c < clauses; ++c) {
+            if(sat_count[c] || reducedSize(c) != min_size) continue;
+            for(int l : formula[c]) {
+                if(value[abs(l)] != 0) continue;
+                if(most_occurrences < ++occur[litIndex(l)]) {
+                    most_occurrences = occur[litIndex(l)];
+                    best = abs(l);
+                }
+            }
+        }
+    } else {
+        // Most occurring lit, or most occurring var
+        bool by_lit = heur == "most_occur_lit";
+        vector<int> occur(2*(vars+1), 0);
+        int max_occur = -1;
+        for(int c = 0; c < clauses; ++c) {
+            if(sat_count[c]) continue;
+            for(int l : formula[c]) {
+                if(value[abs(l)] != 0) continue;
+                int key = by_lit ? litIndex(l) : abs(l);
+                if(max_occur < ++occur[key]) {
+                    max_occur = occur[key];
+                    best = abs(l);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Splits the formula on k vars depth first, emitting each leaf as a cube
+ * Branches are tried negative literal first, like runDivideExperimentSingleVar
+ * 
+ * Params:
+ * - int k: number of vars to split on
+ * - string heur: heuristic used to pick each var (see pickVar)
+ * - bool print: prints each leaf
+ * - bool scan: if true, scans the formula for every pick instead of keeping scores (same ties as heurFind*)
+ * 
+ * Returns:
+ * - vector<Cube>: leaves that are not conflicts (solved leaves can be shallower than k)
+*/
+vector<Cube> CubeGenerator::generate(int k, string heur, bool print, bool scan) {
+    cubes.clear();
+    failed = 0;
+    if(scan && heur != "lookahead") score_mode = -1;
+    else trackScores(heur);
+    if(root_conflict) {
+        if(print) cout << "Formula is UNSAT after propagating unit clauses" << endl;
+        return cubes;
+    }
+    split(k, heur, print);
+    return cubes;
+}
+
+/**
+ * Visits every literal combo of split_vars that starts with the given prefix. Combos are in Gray code 
+ * order, so the next combo flips one literal: only the levels from that literal down are undone and 
+ * redone (about two levels per combo on average), and combos under a conflicting prefix are skipped
+ * 
+ * Params:
+ * - const vector<int>& split_vars: vars to split on (must be unassigned, no levels open)
+ * - int fixed: number of leading vars fixed by prefix
+ * - long long prefix: bit i (from the top) set means split_vars[i] is positive
+ * - visit: called for every combo with its literals and false if it has a conflict
+ *     (when true, vars_remaining and clauses_remaining describe the combo)
+*/
+void CubeGenerator::enumerateSplits(const vector<int>& split_vars, int fixed, long long prefix, const function<void(const vector<int>&, bool)>& visit) {
+    int k = split_vars.size();
+    int low = k - fixed;
+
+    vector<int> lits(k);
+    for(int i = 0; i < k; ++i) {
+        bool positive = i < fixed && ((prefix >> (fixed - 1 - i)) & 1);
+        lits[i] = positive ? split_vars[i] : -split_vars[i];
+    }
+
+    if(root_conflict) {
+        for(long long t = 0; t < (1LL << low); ++t) {
+            if(t) lits[k - 1 - __builtin_ctzll(t)] *= -1;
+            visit(lits, false);
+        }
+        return;
+    }
+
+    // Level of the first conflict (-1 if none)
+    int conflict_level = -1;
+    auto redo = [&](int from) {
+        for(int level = from; level < k; ++level) {
+            if(!assume(lits[level])) {
+                conflict_level = level;
+                return;
+            }
+        }
+    };
+
+    redo(0);
+    visit(lits, conflict_level == -1);
+    for(long long t = 1; t < (1LL << low); ++t) {
+        int level = k - 1 - __builtin_ctzll(t);
+        lits[level] *= -1;
+
+        // Prefix still conflicts
+        if(conflict_level != -1 && level > conflict_level) {
+            visit(lits, false);
+            continue;
+        }
+
+        while(decisions.size() > level) undo();
+        conflict_level = -1;
+        redo(level);
+        visit(lits, conflict_level == -1);
+    }
+
+    while(decisions.size()) undo();
+}
+
+/**
+ * Recursive step of generate()
+*/
+void CubeGenerator::split(int k, string heur, bool print) {
+    if(decisions.size() < k && clauses_remaining > 0) {
+        int var = pickVar(heur);
+
+        // Lookahead found that this node has no solutions
+        if(var < 0) {
+            ++failed;
+            if(decisions.empty()) root_conflict = true;
+            if(print || debug) {
+                cout << "\nLookahead found a conflict, FAILURE" << endl << "\tAssignment: ";
+                for(int l : decisions) cout << l << " ";
+                cout << endl;
+            }
+            return;
+        }
+
+        // Failed literals can satisfy the rest of the formula
+        if(clauses_remaining > 0) {
+            for(int lit : {-var, var}) {
+                if(assume(lit)) {
+                    split(k, heur, print);
+                } else {
+                    ++failed;
+                    if(print || debug) {
+                        cout << "\nAfter removing " << lit << ", FAILURE" << endl << "\tAssignment: ";
+                        for(int l : decisions) cout << l << " ";
+                        cout << endl;
+                    }
+                }
+                undo();
+            }
+            return;
+        }
+    }
+
+    // Leaf
+    Cube cube;
+    cube.lits = decisions;
+    cube.vars_remaining = vars_remaining;
+    cube.clauses_remaining = clauses_remaining;
+    cube.solved = clauses_remaining == 0;
+    cubes.push_back(cube);
+
+    if(print) {
+        cout << "\nCube " << cubes.size() - 1 << "  (" << decisions.size() << " removals)";
+        if(cube.solved) cout << "  SUCCESS";
+        cout << endl << "\tAssignment: ";
+        for(int l : decisions) cout << l << " ";
+        cout << endl;
+        cout << "\tVars: " << vars_remaining << "  (" << vars_remaining * 100.0 / vars << "%)" << endl;
+        cout << "\tClauses: " << clauses_remaining << "  (" << clauses_remaining * 100.0 / clauses << "%)" << endl;
+    }
+}
+
+/**
+ * March-style lookahead: each preselected var (best lookahead_candidates by Jeroslow-Wang) is assumed 
+ * both ways on the trail, and each side is scored by its reduction (newly satisfied clauses + new 
+ * binary clauses). Picks the var with the best 1024 * r(-v) * r(v) + r(-v) + r(v). A literal that 
+ * fails is a failed literal: its negation is asserted at the current level
+ * 
+ * Returns:
+ * - int: the var to split on (0 if no clauses remain, -1 if this node has a conflict)
+*/
+int CubeGenerator::pickVarLookahead() {
+    if(score_mode != 2) trackScores("lookahead");
+
+    int best = 0;
+    double best_score = -1;
+    for(int var : topVars(lookahead_candidates)) {
+        if(value[var] != 0) continue; // assigned by a failed literal
+
+        double reduction[2];
+        bool failed_side[2] = {false, false};
+        for(int side = 0; side < 2; ++side) {
+            int lit = side ? var : -var;
+            int satisfied_before = clauses - clauses_remaining;
+            int binary_before = size_count.size() > 2 ? size_count[2] : 0;
+
+            failed_side[side] = !assume(lit);
+            int satisfied = clauses - clauses_remaining - satisfied_before;
+            int binary = (size_count.size() > 2 ? size_count[2] : 0) - binary_before;
+            reduction[side] = satisfied + max(binary, 0);
+            undo();
+        }
+
+        // Failed literals
+        if(failed_side[0] && failed_side[1]) return -1;
+        if(failed_side[0] || failed_side[1]) {
+            assign(failed_side[0] ? var : -var);
+            if(!propagate()) return -1;
+            if(clauses_remaining == 0) return 0;
+            continue;
+        }
+
+        double score = 1024 * reduction[0] * reduction[1] + reduction[0] + reduction[1];
+        if(score > best_score) {
+            best_score = score;
+            best = var;
+        }
+    }
+
+    // Every candidate was a failed literal, or a later failed literal assigned the best one:
+    // rescore the candidates left, since failed literals changed the formula
+    if(best != 0 && value[best] != 0) best = 0;
+    if(best == 0 && clauses_remaining > 0) return pickVarLookahead();
+    return best;
+}
+
+
+/**
+ * Applies divide and conquer method with heuristics
+ * Applies heur for one var, then removes, then applies next heuristic, and so on
+ * 
+ * Params:
+ * - Circuit c: the formula to operate on
+ * - int k: number of variables to remove
+ * - string heur: heuristic to use to select next var
+ *      - (default) "max_occur_var": picks most occurring variable
+ *      - "max_occur_lit": picks most occurring literal (as a variable)
+ *          ex: -5 occurs 1 time and 5 occurs 6 times, and -10 occurs 5 times and 10 occurs 5 times
+ *             max_occur_lit will choose 5, but max_occur_var will choose 10
+ *      - "jeroslow-wang": uses jeroslow wang equation to pick next
+ *      - "mom": picks var with maximum occurrences in minimum size clauses
+ *      - "lookahead": tries both values of the top candidates and picks the var that simplifies the most
+ * - bool print: shows extra logs
+ * 
+ * Returns:
+ * - prints info about each cube (see CubeGenerator)
+*/
+void divideAndConquerHeur(Circuit c, int k, string heur, bool print) {
+    CubeGenerator generator(c.vars, c.formula);
+    generator.debug = print;
+    vector<Cube> cubes = generator.generate(k, heur, true);
+
+    int min_vars = INT_MAX;
+    for(const Cube& cube : cubes) min_vars = min(min_vars, cube.vars_remaining);
+
+    cout << "\n\nCubes: " << cubes.size() << "  (" << generator.failed << " conflicts)" << endl;
+    if(cubes.size()) cout << "Min Vars: " << min_vars << "  (" << min_vars * 100.0 / c.vars << "%)\n";
+}
+
+/**
+ * Builds the clause database (duplicate literals and tautologies removed) and the watch lists
+ * 
+ * Params:
+ * - int v: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - string heur: decision heuristic (see pickDecision())
+ * - bool learn: learn a clause on every conflict (cdcl in the legacy solve())
+ * - bool p: print logs
+*/
+WatchedSolver::WatchedSolver(int v, vector<vector<int>>& formula, string heur, bool learn, bool p) {
+    vars = formulaMaxVar(formula, v);
+    heuristic = heur;
+    cdcl = learn;
+    print = p;
+
+    watches.assign(2*(vars+1), vector<int>());
+    value.assign(vars+1, 0);
+    reason.assign(vars+1, -1);
+    level.assign(vars+1, 0);
+    occurrences.assign(vars+1, 0);
+    seen.assign(vars+1, 0);
+    stamp = 0;
+    qhead = 0;
+    root_conflict = false;
+    units_pending = false;
+    decisions = 0;
+    propagations = 0;
+    conflicts = 0;
+
+    for(const vector<int>& c : formula) {
+        if(addClause(c) == -2) root_conflict = true;
+    }
+    root_units = trail.size();
+}
+
+/**
+ * Adds a clause, watching its first two literals (non-false literals are moved to the front,
+ * then the false ones from the highest level). Unit clauses of the formula are never watched: they're
+ * assigned as root facts (learned units are kept by solve() instead)
+ * 
+ * Returns:
+ * - int: clause index (-1 if it's satisfied for good, or a unit; -2 if it's false at the root)
+*/
+int WatchedSolver::addClause(vector<int> c) {
+    sort(c.begin(), c.end());
+    c.erase(unique(c.begin(), c.end()), c.end());
+    for(int i = 0; i + 1 < c.size(); ++i) {
+        // Sorted, so -l comes before l only if l > 0, and they're not always adjacent
+        if(binary_search(c.begin(), c.end(), -c[i])) return -1;
+    }
+    for(int l : c) ++occurrences[abs(l)];
+
+    auto rank = [&](int l) {
+        if(litValue(l) != -1) return INT_MAX;
+        return level[abs(l)];
+    };
+    stable_sort(c.begin(), c.end(), [&](int a, int b) { return rank(a) > rank(b); });
+
+    if(c.empty()) return -2;
+    if(c.size() == 1) {
+        if(litValue(c[0]) == -1) return -2;
+        if(litValue(c[0]) == 0) assign(c[0], -1);
+        return -1;
+    }
+    if(decisionLevel() == 0 && litValue(c[0]) == -1) return -2;
+
+    clauses.push_back(c);
+    int ci = clauses.size() - 1;
+    watches[litIndex(c[0])].push_back(ci);
+    watches[litIndex(c[1])].push_back(ci);
+    return ci;
+}
+
+// Makes lit true (from = reason clause, -1 for none)
+void WatchedSolver::assign(int lit, int from) {
+    value[abs(lit)] = lit > 0 ? 1 : -1;
+    reason[abs(lit)] = from;
+    level[abs(lit)] = decisionLevel();
+    trail.push_back(lit);
+}
+
+/**
+ * Assigns the learned units that a backtrack undid (each one counts as a propagation)
+ * 
+ * Returns:
+ * - int: a learned unit that is false (-1 if none)
+*/
+int WatchedSolver::assertLearnedUnits() {
+    units_pending = false;
+    for(int ci : learned_units) {
+        int lit = clauses[ci][0];
+        if(litValue(lit) == -1) return ci;
+        if(litValue(lit) == 0) {
+            assign(lit, ci);
+            ++propagations;
+            if(print) cout << "Unit Clause " << ci+1 << " forced " << lit << endl;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Unit propagation over the watch lists: when a watched literal becomes false, the clause
+ * looks for another non-false literal to watch, and is unit (or conflicting) if there is none
+ * 
+ * Returns:
+ * - int: conflicting clause (-1 if no conflict)
+*/
+int WatchedSolver::propagate() {
+    while(qhead < trail.size()) {
+        int false_lit = -trail[qhead++];
+        vector<int>& ws = watches[litIndex(false_lit)];
+
+        int i = 0, j = 0;
+        while(i < ws.size()) {
+            int ci = ws[i++];
+            vector<int>& c = clauses[ci];
+            if(c.size() < 2) {
+                // Units aren't watched (see addClause), but don't read past one if one is
+                ws[j++] = ci;
+                continue;
+            }
+            if(c[0] == false_lit) swap(c[0], c[1]);
+
+            // Other watch is already true
+            if(litValue(c[0]) == 1) {
+                ws[j++] = ci;
+                continue;
+            }
+
+            // Look for a new literal to watch
+            bool moved = false;
+            for(int k = 2; k < c.size(); ++k) {
+                if(litValue(c[k]) != -1) {
+                    swap(c[1], c[k]);
+                    watches[litIndex(c[1])].push_back(ci);
+                    moved = true;
+                    break;
+                }
+            }
+            if(moved) continue;
+
+            ws[j++] = ci;
+            if(litValue(c[0]) == -1) {
+                // Conflict: keep the rest of the watches
+                while(i < ws.size()) ws[j++] = ws[i++];
+                ws.resize(j);
+                qhead = trail.size();
+                return ci;
+            }
+
+            assign(c[0], ci);
+            ++propagations;
+            if(print) cout << "Unit Clause " << ci+1 << " forced " << c[0] << endl;
+        }
+        ws.resize(j);
+    }
+    return -1;
+}
+
+// Undoes every assignment above level lvl
+void WatchedSolver::backtrack(int lvl) {
+    if(decisionLevel() <= lvl) return;
+    for(int i = trail.size() - 1; i >= trail_lim[lvl]; --i) {
+        int var = abs(trail[i]);
+        value[var] = 0;
+        reason[var] = -1;
+    }
+    trail.resize(trail_lim[lvl]);
+    trail_lim.resize(lvl);
+    qhead = trail.size();
+}
+
+/**
+ * Same learning as the legacy solve(): walks back from the conflicting clause through the reason clauses,
+ * and learns the negation of every decision (or flip) it reaches. Root assignments are left out
+ * 
+ * Returns:
+ * - vector<int>: learned clause
+*/
+vector<int> WatchedSolver::analyze(int conflict) {
+    ++stamp;
+    vector<int> learnt;
+    vector<int> stack;
+    for(int l : clauses[conflict]) {
+        if(seen[abs(l)] != stamp) {
+            seen[abs(l)] = stamp;
+            stack.push_back(abs(l));
+        }
+    }
+
+    while(!stack.empty()) {
+        int var = stack.back();
+        stack.pop_back();
+        if(level[var] == 0) continue;
+
+        if(reason[var] == -1) {
+            learnt.push_back(value[var] > 0 ? -var : var);
+            continue;
+        }
+        for(int l : clauses[reason[var]]) {
+            if(seen[abs(l)] != stamp) {
+                seen[abs(l)] = stamp;
+                stack.push_back(abs(l));
+            }
+        }
+    }
+
+    return learnt;
+}
+
+// Legacy survey score of unassigned var v: positive minus negative occurrences in unsatisfied clauses
+int WatchedSolver::survey(int v) {
+    int result = 0;
+    for(const vector<int>& c : clauses) {
+        bool satisfied = false, has_v = false, has_unassigned = false;
+        int votes = 0;
+        for(int l : c) {
+            int val = litValue(l);
+            if(val == 1) satisfied = true;
+            if(val == 0) has_unassigned = true;
+            if(abs(l) == v) votes += (l < 0) ? -1 : 1, has_v = true;
+        }
+        if(has_v && !satisfied && has_unassigned) result += votes;
+    }
+    return result;
+}
+
+/**
+ * Picks the next decision literal, with the legacy heuristic strings:
+ * - "order": first unassigned var (true)
+ * - "random": random unassigned var and value; "random survey": random var, value from its survey score
+ * - "max survey": var with the largest |survey score| in unsatisfied clauses, value by the score's sign
+ * - "max appearances": var with the most occurrences in all clauses (true)
+ * - "max appearances updated": var with the most occurrences in unsatisfied clauses (true)
+ * - "jeroslow-wang": var with the largest sum of 2^-(unassigned literals) over its clauses (true)
+ * - "mom": var with the most occurrences in the smallest unsatisfied clauses (true)
+ * Ties go to the last var, like the legacy solver (the smallest var for "max appearances updated")
+ * Scores that depend on the current assignment are found with one pass over the clauses
+ * 
+ * Returns:
+ * - int: literal to assign (0 if every var is assigned)
+*/
+int WatchedSolver::pickDecision() {
+    int first_free = 0;
+    for(int v = 1; v <= vars && !first_free; ++v) {
+        if(value[v] == 0) first_free = v;
+    }
+    if(!first_free) return 0;
+
+    if(heuristic.substr(0,6) == "random") {
+        int v = rand() % vars + 1;
+        while(value[v] != 0) {
+            ++v;
+            if(v > vars) v = 1;
+        }
+        if(heuristic == "random") {
+            if(rand() % 2 == 0) v *= -1;
+        } else if(heuristic == "random survey") {
+            if(survey(v) < 0) v *= -1;
+        }
+        return v;
+    }
+
+    if(heuristic == "max appearances") {
+        int best = first_free;
+        for(int v = first_free; v <= vars; ++v) {
+            if(value[v] == 0 && occurrences[v] >= occurrences[best]) best = v;
+        }
+        return best;
+    }
+
+    bool scan = heuristic == "max survey" || heuristic == "max appearances updated" || heuristic == "jeroslow-wang" || heuristic == "mom";
+    if(!scan) return first_free;
+
+    // One pass over the clauses: satisfied, number of unassigned literals, and per-var scores
+    vector<double> score(vars+1, 0);
+    vector<int> pos(vars+1, 0), neg(vars+1, 0);
+    int smallest = INT_MAX;
+    if(heuristic == "mom") {
+        for(const vector<int>& c : clauses) {
+            int unassigned = 0;
+            bool satisfied = false;
+            for(int l : c) {
+                int val = litValue(l);
+                if(val == 1) satisfied = true;
+                if(val == 0) ++unassigned;
+            }
+            if(!satisfied && unassigned > 0) smallest = min(smallest, unassigned);
+        }
+    }
+
+    for(const vector<int>& c : clauses) {
+        int unassigned = 0;
+        bool satisfied = false;
+        for(int l : c) {
+            int val = litValue(l);
+            if(val == 1) satisfied = true;
+            if(val == 0) ++unassigned;
+        }
+        if(unassigned == 0) continue;
+
+        if(heuristic == "jeroslow-wang") {
+            // Counts satisfied clauses too, like the legacy version
+            double w = pow(2, -unassigned);
+            for(int l : c) {
+                if(value[abs(l)] == 0) score[abs(l)] += w;
+            }
+            continue;
+        }
+        if(satisfied) continue;
+        if(heuristic == "mom" && unassigned != smallest) continue;
+
+        for(int l : c) {
+            if(value[abs(l)] != 0) continue;
+            if(l > 0) ++pos[l];
+            else ++neg[-l];
+        }
+    }
+
+    int best = first_free;
+    double best_score = (heuristic == "max survey") ? 0 : -1;
+    for(int v = first_free; v <= vars; ++v) {
+        if(value[v] != 0) continue;
+
+        if(heuristic == "max survey") {
+            int curr = pos[v] - neg[v];
+            if(abs(best_score) <= abs(curr)) {
+                best_score = curr;
+                best = (curr < 0) ? -v : v;
+            }
+        } else if(heuristic == "max appearances updated") {
+            if(pos[v] + neg[v] > best_score) {
+                best_score = pos[v] + neg[v];
+                best = v;
+            }
+        } else if(heuristic == "jeroslow-wang") {
+            if(score[v] >= best_score) {
+                best_score = score[v];
+                best = v;
+            }
+        } else {
+            // mom, k = 1
+            double curr = (pos[v] + neg[v]) * 2.0 + pos[v] * neg[v];
+            if(curr >= best_score) {
+                best_score = curr;
+                best = v;
+            }
+        }
+    }
+
+    if(print) cout << "Tried " << best << " with " << heuristic << " score " << best_score << endl;
+    return best;
+}
+
+/**
+ * Runs the search: propagate, and on a conflict flip the last decision (asserted by the learned clause
+ * if cdcl), until every var is assigned or a conflict happens with no decisions left
+ * 
+ * Params:
+ * - const unordered_set<int>& assumptions: literals fixed before the search (never flipped)
+ * 
+ * Returns:
+ * - bool: true if SAT (the trail is then a full model)
+*/
+bool WatchedSolver::solve(const unordered_set<int>& assumptions) {
+    if(root_conflict) return false;
+    for(int l : assumptions) {
+        if(abs(l) > vars || litValue(l) == 1) continue;
+        if(litValue(l) == -1) return false;
+        assign(l, -1);
+    }
+
+    while(true) {
+        int confl = units_pending ? assertLearnedUnits() : -1;
+        if(confl < 0) confl = propagate();
+        if(confl >= 0) {
+            ++conflicts;
+            if(print) cout << "Conflict in clause " << confl+1 << endl;
+            if(decisionLevel() == 0) return false;
+
+            int d = trail[trail_lim.back()];
+            vector<int> learnt;
+            if(cdcl) learnt = analyze(confl);
+            backtrack(decisionLevel() - 1);
+
+            units_pending = !learned_units.empty();
+
+            int from = -1;
+            if(cdcl) {
+                if(print) {
+                    cout << "Learnt clause added: ";
+                    for(int n : learnt) cout << n << " ";
+                    cout << endl;
+                }
+                learned.push_back(learnt);
+
+                // Every assignment at the conflict's level follows from its decision, so the clause has -d,
+                // and it's unit on -d after backtracking. Units are kept unwatched (see assertLearnedUnits())
+                int ci;
+                if(learnt.size() == 1) {
+                    ++occurrences[abs(learnt[0])];
+                    clauses.push_back(learnt);
+                    ci = clauses.size() - 1;
+                    learned_units.push_back(ci);
+                    units_pending = true;
+                } else {
+                    ci = addClause(learnt);
+                    if(ci == -2) return false;
+                }
+                if(ci >= 0 && find(learnt.begin(), learnt.end(), -d) != learnt.end()) from = ci;
+            }
+
+            if(print) cout << "Flipped " << d << " to " << -d << endl;
+            if(litValue(-d) == 0) assign(-d, from);
+            continue;
+        }
+
+        int lit = pickDecision();
+        if(lit == 0) return true;
+
+        trail_lim.push_back(trail.size());
+        assign(lit, -1);
+        ++decisions;
+    }
+}
+
+/**
+ * Solves the formula (same interface as before, so old experiments still run) on WatchedSolver
+ * Like the legacy version, learned clauses are appended to formula, and counter counts its loop iterations:
+ * one per decision or unit deduction (flips are part of the conflict's iteration), one for the
+ * final conflict if UNSAT, and none once every clause is satisfied
+ * 
+ * Params:
+ * - vector<vector<int>>& formula: the SAT formula
+ * - unordered_set<int>& s: literals already assigned (kept fixed); returned with the model if SAT
+ * - int vars: number of vars
+ * - string heuristic: decision heuristic (see WatchedSolver::pickDecision())
+ * - bool cdcl: learn a clause on every conflict
+ * - bool print: print logs
+ * - int& counter: increased by the number of legacy loop iterations
+ * 
+ * Returns:
+ * - bool: true if SAT
+*/
+bool solve(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter) {
+    WatchedSolver solver(vars, formula, heuristic, cdcl, print);
+    bool sat = solver.solve(s);
+
+    long long iterations = solver.root_units + solver.decisions + solver.propagations;
+    if(!sat) ++iterations;
+    else {
+        // The legacy loop stopped as soon as every clause was satisfied: leave out the decisions and
+        // deductions after the trail position where that happened (no conflict can happen past it)
+        vector<int> position(solver.vars+1, -1);
+        for(int i = 0; i < solver.trail.size(); ++i) position[abs(solver.trail[i])] = i;
+        int satisfied_at = -1;
+        for(const vector<int>& c : formula) {
+            int first_true = INT_MAX;
+            for(int l : c) {
+                if(solver.litValue(l) == 1) first_true = min(first_true, position[abs(l)]);
+            }
+            satisfied_at = max(satisfied_at, first_true);
+        }
+
+        vector<char> is_decision(solver.trail.size(), 0);
+        for(int p : solver.trail_lim) is_decision[p] = 1;
+        for(int i = satisfied_at + 1; i < solver.trail.size(); ++i) {
+            if(is_decision[i] || solver.reason[abs(solver.trail[i])] >= 0) --iterations;
+        }
+    }
+    counter += iterations;
+
+    for(const vector<int>& c : solver.learned) formula.push_back(c);
+
+    if(sat) {
+        s.clear();
+        for(int l : solver.trail) {
+            if(abs(l) <= vars) s.insert(l);
+        }
+    }
+    return sat;
+}
+
+/**
+ * Loads a formula into a minisat solver (var v is minisat var v-1), with assignment logs turned off
+ * 
+ * Returns:
+ * - bool: false if the formula is trivially UNSAT
+*/
+bool loadMinisat(Minisat::Solver& solver, int vars, vector<vector<int>>& formula) {
+    // The modified solver logs every assignment by default
+    solver.verification_logs = false;
+
+    while(solver.nVars() < vars) solver.newVar();
+
+    Minisat::vec<Minisat::Lit> lits;
+    for(const vector<int>& c : formula) {
+        lits.clear();
+        for(int l : c) lits.push(Minisat::mkLit(abs(l) - 1, l < 0));
+        if(!solver.addClause_(lits)) return false;
+    }
+    return true;
+}
+
+/**
+ * Solves the whole formula with a single minisat solver, to compare against solveCubes()
+ * 
+ * Params:
+ * - vector<int>& model: returned, model[v] is v or -v (size vars+1) if SAT
+ * 
+ * Returns:
+ * - bool: true if SAT
+*/
+bool CubeSolver::solveBaseline(vector<int>& model) {
+    auto start = chrono::high_resolution_clock::now();
+
+    Minisat::Solver solver;
+    solver.verbosity = 0;
+    bool sat = loadMinisat(solver, vars, formula) && solver.solve();
+    if(sat) {
+        model.assign(vars+1, 0);
+        for(int v = 1; v <= vars; ++v) model[v] = (solver.modelValue(v-1) == Minisat::l_True) ? v : -v;
+    }
+
+    baseline_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    return sat;
+}
+
+/**
+ * Solves cubes in parallel. Each worker keeps one minisat solver for all of its cubes, so learned
+ * clauses are reused (the final conflict of an UNSAT cube is also added as a clause). Once any cube 
+ * is SAT, the other workers are interrupted
+ * 
+ * Params:
+ * - const vector<Cube>& cubes: cubes from CubeGenerator (conflict branches must already be removed)
+ * - vector<int>& model: returned, model[v] is v or -v (size vars+1) if SAT
+ * - int num_threads: 0 = all hardware threads
+ * 
+ * Returns:
+ * - bool: true if SAT (false means every cube is UNSAT, so the formula is UNSAT)
+*/
+bool CubeSolver::solveCubes(const vector<Cube>& cubes, vector<int>& model, int num_threads) {
+    auto start = chrono::high_resolution_clock::now();
+
+    int n = cubes.size();
+    int workers = min(threadsToUse(num_threads), max(1, n));
+    cube_seconds.assign(n, -1);
+    cube_results.assign(n, -1);
+    cube_worker.assign(n, -1);
+
+    vector<Minisat::Solver*> solvers(workers, nullptr);
+    atomic<int> next(0);
+    atomic<bool> found(false), unsat(false);
+    mutex model_mutex;
+
+    // Stops every other worker
+    auto interruptOthers = [&](Minisat::Solver* self) {
+        for(Minisat::Solver* other : solvers) {
+            if(other && other != self) other->interrupt();
+        }
+    };
+
+    parallelFor(workers, workers, [&](int w) {
+        Minisat::Solver solver;
+        solver.verbosity = 0;
+        {
+            lock_guard<mutex> lock(model_mutex);
+            solvers[w] = &solver;
+        }
+        bool ok = loadMinisat(solver, vars, formula);
+
+        Minisat::vec<Minisat::Lit> assumps;
+        for(int i = next++; ok && !found && !unsat && i < n; i = next++) {
+            auto cube_start = chrono::high_resolution_clock::now();
+
+            assumps.clear();
+            for(int l : cubes[i].lits) assumps.push(Minisat::mkLit(abs(l) - 1, l < 0));
+            Minisat::lbool result = solver.solveLimited(assumps);
+
+            cube_seconds[i] = chrono::duration<double>(chrono::high_resolution_clock::now() - cube_start).count();
+            cube_worker[i] = w;
+
+            if(result == Minisat::l_True) {
+                cube_results[i] = 1;
+                lock_guard<mutex> lock(model_mutex);
+                if(!found) {
+                    found = true;
+                    model.assign(vars+1, 0);
+                    for(int v = 1; v <= vars; ++v) model[v] = (solver.modelValue(v-1) == Minisat::l_True) ? v : -v;
+                    interruptOthers(&solver);
+                }
+            } else if(result == Minisat::l_False) {
+                cube_results[i] = 0;
+                // The final conflict only uses assumptions and is implied by the formula
+                Minisat::vec<Minisat::Lit> learnt;
+                for(int j = 0; j < solver.conflict.size(); ++j) learnt.push(solver.conflict[j]);
+                if(!solver.addClause_(learnt)) ok = false;
+            }
+        }
+
+        // The formula itself is UNSAT
+        lock_guard<mutex> lock(model_mutex);
+        if(!ok && !unsat) {
+            unsat = true;
+            interruptOthers(&solver);
+        }
+        solvers[w] = nullptr;
+    });
+
+    wall_seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+    if(!found || unsat) return false;
+
+    // Double check the model against the original formula
+    for(const vector<int>& c : formula) {
+        bool satisfied = false;
+        for(int l : c) {
+            if(model[abs(l)] == l) {
+                satisfied = true;
+                break;
+            }
+        }
+        if(!satisfied) {
+            cout << "VALIDATION: FAILED (model doesn't satisfy the formula)" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Prints the time of each cube, and the speedup against the single solver (if solveBaseline() was run)
+*/
+void CubeSolver::printStats() {
+    int solved = 0;
+    double total = 0;
+    for(int i = 0; i < cube_seconds.size(); ++i) {
+        if(cube_results[i] == -1) continue;
+        ++solved;
+        total += cube_seconds[i];
+        if(debug) {
+            cout << "Cube " << i << " (worker " << cube_worker[i] << "): " << (cube_results[i] ? "SAT" : "UNSAT");
+            cout << " in " << cube_seconds[i] << " seconds" << endl;
+        }
+    }
+
+    cout << "Cubes solved: " << solved << " / " << cube_seconds.size() << endl;
+    cout << "Total cube time: " << total << " seconds" << endl;
+    cout << "Wall clock time: " << wall_seconds << " seconds" << endl;
+    if(baseline_seconds >= 0) {
+        cout << "Single solver time: " << baseline_seconds << " seconds" << endl;
+        cout << "Speedup: " << baseline_seconds / wall_seconds << "x" << endl;
+    }
+}
+
+/**
+ * Extracts the backbone. Candidates start as the first model; a candidate l is backbone if
+ * the formula plus assumption -l is UNSAT (then l is added as a unit clause, which helps the later calls).
+ * A SAT call gives a new model, and candidates it disagrees with are dropped without being tested
+ * 
+ * Params:
+ * - long long conflict_budget: conflicts allowed per candidate call (-1 for no limit)
+ * 
+ * Returns:
+ * - bool: false if the formula is UNSAT (no backbone)
+*/
+bool BackboneExtractor::extract(long long conflict_budget) {
+    auto start = chrono::high_resolution_clock::now();
+    backbone.clear();
+    solves = 1;
+    filtered = 0;
+    unknown = 0;
+
+    Minisat::Solver solver;
+    solver.verbosity = 0;
+    if(!loadMinisat(solver, vars, formula) || !solver.solve()) {
+        seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        return false;
+    }
+
+    // candidate[v] is v's literal in every model found so far (0 once dropped)
+    vector<int> candidate(vars+1, 0);
+    for(int v = 1; v <= vars; ++v) candidate[v] = (solver.modelValue(v-1) == Minisat::l_True) ? v : -v;
+
+    Minisat::vec<Minisat::Lit> assumps;
+    for(int v = 1; v <= vars; ++v) {
+        int lit = candidate[v];
+        if(lit == 0) continue;
+
+        // Assigned at the root (units and their propagations, including earlier backbone literals)
+        if(solver.value(v-1) != Minisat::l_Undef) {
+            backbone.push_back(lit);
+            continue;
+        }
+
+        Minisat::Lit p = Minisat::mkLit(v-1, lit < 0);
+        assumps.clear();
+        assumps.push(~p);
+        if(conflict_budget >= 0) solver.setConfBudget(conflict_budget);
+        else solver.budgetOff();
+        Minisat::lbool result = solver.solveLimited(assumps);
+        ++solves;
+
+        if(result == Minisat::l_False) {
+            backbone.push_back(lit);
+            solver.addClause(p);
+        } else if(result == Minisat::l_True) {
+            // Model filtering: the new model disagrees with lit, and maybe with later candidates
+            candidate[v] = 0;
+            for(int u = v+1; u <= vars; ++u) {
+                if(candidate[u] == 0) continue;
+                if((solver.modelValue(u-1) == Minisat::l_True) != (candidate[u] > 0)) {
+                    candidate[u] = 0;
+                    ++filtered;
+                }
+            }
+        } else {
+            ++unknown;
+        }
+
+        if(debug) cout << "Var " << v << ": " << (result == Minisat::l_False ? "backbone" : result == Minisat::l_True ? "not backbone" : "unknown") << endl;
+    }
+
+    seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+    return true;
+}
+
+/**
+ * Formula with the backbone literals assigned (satisfied clauses and false literals removed)
+ * The backbone is closed under unit propagation, so no clause becomes unit (unless some candidates were unknown)
+*/
+vector<vector<int>> BackboneExtractor::simplifiedFormula() {
+    return assign(formula, unordered_set<int>(backbone.begin(), backbone.end()));
+}
+
+// Prints backbone size and solver calls
+void BackboneExtractor::printStats() {
+    cout << "Backbone: " << backbone.size() << " / " << vars << " vars (" << backbone.size() * 100.0 / max(vars, 1) << "%)" << endl;
+    cout << "Solver calls: " << solves << "  (" << filtered << " candidates dropped by models, " << unknown << " unknown)" << endl;
+    cout << "Time: " << seconds << " seconds" << endl;
+}
+
+/**
+* Calculates heuristic list (ex: list of most occurring to least occurring variables)
+*
+* Params:
+* - heur: {"occurrences", "balance"}
+* - formula: the SAT formula
+* - vars: the number of variables
+* 
+* Returns:
+* - vector<int>: the heuristic list, in descending order
+*/
+vector<int> calculateHeurList(string heur, vector<vector<int>>& formula, int vars) {
+    // Maintain map from the var to the heuristic, use a vector
+    vector<int> var_to_heur(vars+1, 0);
+
+    // Final result
+    vector<int> result;
+
+    // Most occurrences
+    if(heur == "occurrences") {
+        // Iterate through formula, adding occurrences
+        for(vector<int> clause : formula) {
+            for(int lit : clause) {
+                ++var_to_heur[abs(lit)];
+            }
+        }
+
+        // Add to priority queue
+        priority_queue<pair<int, int>> pq;
+        for(int var = 1; var < var_to_heur.size(); ++var) {
+            pq.push(make_pair(var_to_heur[var], var));
+        }
+
+        // Remove from queue to add to result
+        while(pq.size()) {
+            pair<int, int> p = pq.top();
+            pq.pop();
+
+            result.push_back(p.second);
+        }
+    }
+
+    return result;
+}
+
+
+/**
+* Given an assignments filename, parses into set
+*/
+unordered_set<int> parseAssignmentsFile(string filename, int& propagations) {
+    unordered_set<int> assignments;
+    ifstream inFile(filename);
+    if (inFile.is_open()) {
+        string line;
+        // Read the first line to get the number of propagations
+        if (getline(inFile, line)) {
+            istringstream iss(line);
+            string keyword;
+            iss >> keyword; // Read "Propagations:"
+            iss >> propagations;
+        } else {
+            cerr << "Error reading file: " << filename << endl;
+            return assignments;
+        }
+
+        // Read the second line to get the assignments
+        if (getline(inFile, line)) {
+            istringstream iss(line);
+            int num;
+            while (iss >> num) {
+                assignments.insert(num);
+            }
+        } else {
+            cerr << "Error reading file: " << filename << endl;
+            return assignments;
+        }
+        // cout << "File parsed successfully: " << filename << endl;
+    } else {
+        cerr << "Error opening file: " << filename << endl;
+    }
+    inFile.close();
+    return assignments;
+}
+
+/**
+* Given an assignment, simplifies the formula by setting those assignments
+* Does NOT do unit propagation
+*/
+vector<vector<int>> assign(vector<vector<int>>& formula, unordered_set<int> assignments) {
+    // Create new formula
+    vector<vector<int>> new_formula;
+
+    for(vector<int> c : formula) {
+        bool skip = false;
+        vector<int> new_clause;
+        for(int lit : c) {
+            // If skip
+            if(assignments.count(lit)) {
+                skip = true;
+                break;
+            }
+
+            // Else, add to new clause if needed
+            if(assignments.count(lit * -1) == 0) new_clause.push_back(lit);
+        }
+
+        if(!skip && new_clause.size()) new_formula.push_back(new_clause);
+    }
+
+    return new_formula;
+}
+
+/*
+* Parses heuristic list file from minisat_experiments/
+*/
+vector<int> parseHeurListFile(string filename, int& propagations) {
+    vector<int> heuristicList;
+    ifstream file(filename);
+    string line;
+
+    if (file.is_open()) {
+        // Read the heuristic list
+        while (getline(file, line)) {
+            if (line.empty()) {
+                // Empty line encountered, stop reading the heuristic list
+                break;
+            }
+            heuristicList.push_back(stoi(line));
+        }
+
+        // Read the line containing the number of propagations
+        if (getline(file, line)) {
+            size_t pos = line.find(':');
+            if (pos != string::npos) {
+                propagations = stoi(line.substr(pos + 1));
+            }
+        } else {
+            cerr << "Error: File format incorrect. Expected propagations." << endl;
+            return heuristicList; // Return heuristic list read so far
+        }
+
+        file.close();
+    } else {
+        cerr << "Error: Unable to open file " << filename << endl;
+    }
+
+    return heuristicList;
+}
+
+/*
+* Compares two heuristic lists, and returns a score, given a comparison metric
+* metrics: "index diff MSE", "index diff"
+*/
+int compareHeurLists(const vector<int> l1, const vector<int> l2, string metric) {
+    int score = 0;
+
+    // Map each value in l2 to its index
+    unordered_map<int, int> l2_index;
+    for(int i = 0; i < l2.size(); ++i) {
+        l2_index[l2[i]] = i;
+    }
+
+    // Find score
+    for(int i = 0; i < l1.size(); ++i) {
+        int diff = abs(i - l2_index[l1[i]]);
+
+        // mean square of differences of indices
+        if(metric == "index diff MSE") {
+            score += (diff * diff);
+        }
+        // sum up differences of indices without squaring
+        else if(metric == "index diff") {
+            score += diff;
+        }
+    }
+
+    return score;
+}
+
+
+
+/**
+ * Opens a binary snapshot log (see SnapshotLog in funcs.hpp) and finds every record
+ * If the log has no index (the solver was killed before closing it), the records are found
+ * by scanning, and a partly written last record is dropped
+ * 
+ * Params:
+ * - const string& filename: the log file
+*/
+SnapshotLog::SnapshotLog(const string& filename) {
+    data = nullptr;
+    size = 0;
+    vars = 0;
+    keyframe_every = 0;
+    current = -1;
+    propagations = 0;
+
+    fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        cerr << "Error opening file: " << filename << endl;
+        return;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < 16) {
+        cerr << "Error: " << filename << " is not a valid snapshot log." << endl;
+        return;
+    }
+    size = st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapped == MAP_FAILED) {
+        cerr << "Error: could not mmap " << filename << endl;
+        return;
+    }
+    data = (const char*)mapped;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    int32_t header[2];
+    memcpy(header, data + 8, sizeof(header));
+    if(memcmp(data, "SATSNAP1", 8) != 0) {
+        cerr << "Error: " << filename << " is not a valid snapshot log." << endl;
+        munmap(mapped, size);
+        data = nullptr;
+        return;
+    }
+    vars = header[0];
+    keyframe_every = header[1];
+
+    // Index at the end: int64 offsets[n], int64 n, "SNAPIDX1"
+    int64_t n = -1;
+    if(size >= 32 && memcmp(data + size - 8, "SNAPIDX1", 8) == 0) {
+        memcpy(&n, data + size - 16, sizeof(n));
+        if(n < 0 || (size_t)(16 + 8*n + 16) > size) n = -1;
+    }
+    if(n >= 0) {
+        offsets.resize(n);
+        memcpy(offsets.data(), data + size - 16 - 8*n, 8*n);
+        return;
+    }
+
+    // No index, so scan the records
+    size_t pos = 16;
+    while(pos + 16 <= size) {
+        int32_t counts[2];
+        memcpy(counts, data + pos + 8, sizeof(counts));
+        size_t end = pos + 16 + 4*(size_t)counts[1];
+        if(counts[0] < 0 || counts[1] < 0 || end > size) break;
+        offsets.push_back(pos);
+        pos = end;
+    }
+}
+
+// SnapshotLog destructor
+SnapshotLog::~SnapshotLog() {
+    if(data != nullptr) munmap((void*)data, size);
+    if(fd >= 0) close(fd);
+}
+
+// Number of literals record i keeps from the previous snapshot (0 for keyframes)
+int SnapshotLog::recordKeep(int i) const {
+    int32_t keep;
+    memcpy(&keep, data + offsets[i] + 8, sizeof(keep));
+    return keep;
+}
+
+/**
+ * Applies record i on top of the current trail (which has to be the trail of snapshot i-1,
+ * unless record i is a keyframe)
+ * 
+ * Returns:
+ * - bool: false if the record doesn't fit the current trail
+*/
+bool SnapshotLog::applyRecord(int i) {
+    const char* p = data + offsets[i];
+    int64_t props;
+    int32_t counts[2];
+    memcpy(&props, p, sizeof(props));
+    memcpy(counts, p + 8, sizeof(counts));
+    if(counts[0] > trail.size()) {
+        cerr << "Error: snapshot " << i << " keeps " << counts[0] << " literals, but the trail has " << trail.size() << endl;
+        return false;
+    }
+
+    trail.resize(counts[0] + counts[1]);
+    memcpy(trail.data() + counts[0], p + 16, sizeof(int32_t) * counts[1]);
+    propagations = props;
+    current = i;
+    return true;
+}
+
+// Moves to the next snapshot (false at the end of the log)
+bool SnapshotLog::next() {
+    if(data == nullptr || current + 1 >= (int)offsets.size()) return false;
+    return applyRecord(current + 1);
+}
+
+/**
+ * Moves to snapshot i, replaying from the closest keyframe at or before it
+ * (or from the current snapshot if that is closer)
+ * 
+ * Returns:
+ * - bool: false if i is out of range
+*/
+bool SnapshotLog::seek(int i) {
+    if(data == nullptr || i < 0 || i >= (int)offsets.size()) return false;
+
+    int start = i;
+    while(start > 0 && start > current && recordKeep(start) != 0) --start;
+    if(start == current) ++start;
+    else if(start > current) trail.clear();
+    else {
+        // Going backwards: start over from the keyframe
+        while(start > 0 && recordKeep(start) != 0) --start;
+        trail.clear();
+    }
+
+    for(int j = start; j <= i; ++j) {
+        if(!applyRecord(j)) return false;
+    }
+    return true;
+}
+
+// Whether input is a snapshot log file (instead of a folder of assignment files)
+bool isSnapshotLog(string input) {
+    struct stat st;
+    return stat(input.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/**
+ * Converts a folder of text assignment snapshots (one file per snapshot, "Propagations: N" then the trail)
+ * into a binary snapshot log, so old traces can be read with SnapshotLog
+ * 
+ * Params:
+ * - string input_folder: folder with the assignment files (ex: "../minisat/output_assignments/")
+ * - string log_file: output log
+ * - int vars: number of vars (stored in the header)
+ * - int keyframe_every: every keyframe_every-th snapshot is written in full
+ * 
+ * Returns:
+ * - int: number of snapshots written (-1 if the log couldn't be opened or written)
+*/
+int writeSnapshotLog(string input_folder, string log_file, int vars, int keyframe_every) {
+    FILE* file = fopen(log_file.c_str(), "wb");
+    if(file == nullptr) {
+        cerr << "Error opening file: " << log_file << endl;
+        return -1;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    int32_t header[2] = {vars, keyframe_every};
+    bool ok = fwrite("SATSNAP1", 1, 8, file) == 8;
+    ok = ok && fwrite(header, sizeof(int32_t), 2, file) == 2;
+    int64_t bytes = 16;
+
+    vector<int64_t> offsets;
+    vector<int> prev, trail;
+    for(string filename : listSnapshotFiles(input_folder)) {
+        if(!ok) break;
+        ifstream in(input_folder + filename);
+        string keyword;
+        int64_t propagations = 0;
+        if(!(in >> keyword >> propagations)) {
+            cerr << "Error reading file: " << filename << endl;
+            continue;
+        }
+        trail.clear();
+        int lit;
+        while(in >> lit) trail.push_back(lit);
+
+        // Keep the prefix shared with the previous snapshot
+        int32_t keep = 0;
+        if(offsets.size() % keyframe_every != 0) {
+            while(keep < prev.size() && keep < trail.size() && prev[keep] == trail[keep]) ++keep;
+        }
+        int32_t counts[2] = {keep, (int32_t)(trail.size() - keep)};
+        ok = fwrite(&propagations, sizeof(propagations), 1, file) == 1;
+        ok = ok && fwrite(counts, sizeof(int32_t), 2, file) == 2;
+        ok = ok && fwrite(trail.data() + keep, sizeof(int32_t), counts[1], file) == (size_t)counts[1];
+
+        offsets.push_back(bytes);
+        bytes += 16 + 4*(int64_t)counts[1];
+        swap(prev, trail);
+    }
+
+    int64_t n = offsets.size();
+    ok = ok && fwrite(offsets.data(), sizeof(int64_t), n, file) == (size_t)n;
+    ok = ok && fwrite(&n, sizeof(n), 1, file) == 1;
+    ok = ok && fwrite("SNAPIDX1", 1, 8, file) == 8;
+    if(fclose(file) != 0) ok = false;
+
+    if(!ok) {
+        cerr << "Error writing file: " << log_file << endl;
+        return -1;
+    }
+    return n;
+}
+
+/**
+ * Builds the literal occurrence lists and the "occurrences" heuristic list of the original formula
+ * 
+ * Params:
+ * - int v: number of vars
+ * - vector<vector<int>>& f: the SAT formula
+ * - int k: size of the top-k sets compared by topKOverlap()
+*/
+HeurListDrift::HeurListDrift(int v, vector<vector<int>>& f, int k) : formula(f) {
+    vars = v;
+    top_k = k;
+
+    value.assign(vars+1, 0);
+    var_occ.assign(vars+1, 0);
+    sat_count.assign(formula.size(), 0);
+
+    // Clauses of literal l are occ[occ_start[i]] .. occ[occ_start[i+1]-1], i = 2|l| + (l < 0)
+    buildOccurrenceIndex(formula, vars, true, occ_start, occ);
+    for(int v = 1; v <= vars; ++v) var_occ[v] = occ_start[2*v+2] - occ_start[2*v];
+
+    original_list = currentList();
+    original_rank.assign(vars+1, 0);
+    for(int i = 0; i < original_list.size(); ++i) original_rank[original_list[i]] = i;
+}
+
+/**
+ * Makes lit true (sign = 1) or undoes it (sign = -1), updating the occurrences of vars in unsatisfied clauses
+*/
+void HeurListDrift::setLiteral(int lit, int sign) {
+    int i = 2*abs(lit) + (lit < 0);
+    for(int j = occ_start[i]; j < occ_start[i+1]; ++j) {
+        int c = occ[j];
+        int before = sat_count[c];
+        sat_count[c] += sign;
+
+        // Clause became satisfied or unsatisfied
+        if((before == 0) != (sat_count[c] == 0)) {
+            for(int l : formula[c]) var_occ[abs(l)] -= sign;
+        }
+    }
+    value[abs(lit)] = (sign > 0) ? (lit > 0 ? 1 : -1) : 0;
+}
+
+/**
+ * Moves to a new snapshot, only changing the literals that differ from the current one
+ * 
+ * Params:
+ * - const vector<int>& lits: the assigned literals of the snapshot
+*/
+void HeurListDrift::setAssignments(const vector<int>& lits) {
+    vector<signed char> next(vars+1, 0);
+    for(int l : lits) {
+        if(abs(l) <= vars) next[abs(l)] = l > 0 ? 1 : -1;
+    }
+
+    vector<int> kept;
+    for(int l : assigned) {
+        if(next[abs(l)] == (l > 0 ? 1 : -1)) kept.push_back(l);
+        else setLiteral(l, -1);
+    }
+    for(int l : lits) {
+        if(abs(l) > vars || value[abs(l)] != 0) continue;
+        setLiteral(l, 1);
+        kept.push_back(l);
+    }
+    assigned = kept;
+}
+
+/**
+ * Current "occurrences" heuristic list: same order as calculateHeurList("occurrences", assign(formula, assignments), vars)
+ * (assigned vars have no occurrences left, ties go to the larger var)
+*/
+vector<int> HeurListDrift::currentList() {
+    vector<pair<int, int>> order(vars);
+    for(int v = 1; v <= vars; ++v) order[v-1] = make_pair(value[v] ? 0 : var_occ[v], v);
+    sort(order.begin(), order.end(), greater<pair<int, int>>());
+
+    vector<int> list(vars);
+    for(int i = 0; i < vars; ++i) list[i] = order[i].second;
+    return list;
+}
+
+/**
+ * Kendall tau between the original list and list (1 = same order, -1 = reversed)
+ * Discordant pairs are counted as inversions with a Fenwick tree
+*/
+double HeurListDrift::kendallTau(const vector<int>& list) {
+    int n = list.size();
+    if(n < 2) return 1;
+
+    vector<int> tree(n+1, 0);
+    long long inversions = 0;
+    for(int i = 0; i < n; ++i) {
+        // Number of earlier vars ranked after this one in the original list
+        int r = original_rank[list[i]] + 1;
+        int smaller = 0;
+        for(int j = r; j > 0; j -= j & -j) smaller += tree[j];
+        inversions += i - smaller;
+        for(int j = r; j <= n; j += j & -j) ++tree[j];
+    }
+
+    double pairs = (double)n * (n - 1) / 2;
+    return 1 - 2 * inversions / pairs;
+}
+
+/**
+ * Fraction of the original top k vars that are still in the top k of list
+*/
+double HeurListDrift::topKOverlap(const vector<int>& list) {
+    int k = min(top_k, (int)list.size());
+    if(k == 0) return 1;
+
+    int overlap = 0;
+    for(int i = 0; i < k; ++i) {
+        if(original_rank[list[i]] < k) ++overlap;
+    }
+    return overlap * 1.0 / k;
+}
+
+/**
+ * Reads every snapshot of a solver trace once, in order, and writes drift metrics of the heuristic list
+ * for each one (compared with the list of the original formula)
+ * 
+ * Params:
+ * - string input: folder with the assignment files (ex: "../minisat/output_assignments/") or snapshot log file
+ * - string csv_file: output file, one row per snapshot
+ * 
+ * Returns:
+ * - int: number of snapshots read
+*/
+int HeurListDrift::run(string input, string csv_file) {
+    ofstream out(csv_file);
+    if(!out.is_open()) {
+        cout << "ERROR: could not open " << csv_file << endl;
+        return 0;
+    }
+    out << "snapshot,file,propagations,assigned,kendall_tau,top_k_overlap,index_diff" << endl;
+
+    int snapshots = 0;
+    auto writeRow = [&](const string& file, long long propagations, const vector<int>& lits) {
+        setAssignments(lits);
+
+        vector<int> list = currentList();
+        long long index_diff = 0;
+        for(int j = 0; j < list.size(); ++j) index_diff += abs(j - original_rank[list[j]]);
+
+        out << ++snapshots << "," << file << "," << propagations << "," << assigned.size() << ","
+            << kendallTau(list) << "," << topKOverlap(list) << "," << index_diff << "\n";
+    };
+
+    if(isSnapshotLog(input)) {
+        SnapshotLog log(input);
+        string file = input.substr(input.find_last_of('/') + 1);
+        while(log.next()) writeRow(file, log.propagations, log.trail);
+    } else {
+        for(string filename : listSnapshotFiles(input)) {
+            int propagations = 0;
+            unordered_set<int> assignments = parseAssignmentsFile(input + filename, propagations);
+            writeRow(filename, propagations, vector<int>(assignments.begin(), assignments.end()));
+        }
+    }
+
+    return snapshots;
+}
+
+
+
+/**
+ * Computes the span of every variable in one pass over the formula
+ * Same definition as findSpan(): distance covered by the clauses a variable is in,
+ * where the clause order can wrap around (circular) if circular is true
+ * 
+ * Params:
+ * - int vars: the number of variables
+ * - vector<vector<int>> formula: the SAT formula
+ * - bool circular: if false, span is just last clause - first clause
+ * 
+ * Returns:
+ * - vector<int>: spans[v] is the span of var v (-1 if v doesn't appear)
+*/
+vector<int> findAllSpans(int vars, vector<vector<int>>& formula, bool circular) {
+    int c = formula.size();
+
+    // First, last, and previous clause seen for each var, and largest gap between consecutive clauses
+    vector<int> first(vars+1, -1), last(vars+1, -1), max_gap(vars+1, 0);
+
+    for(int i = 0; i < c; ++i) {
+        for(int lit : formula[i]) {
+            int var = abs(lit);
+            if(var > vars) continue;
+
+            // Skip var appearing twice in the same clause
+            if(last[var] == i) continue;
+
+            if(first[var] == -1) {
+                first[var] = i;
+            } else {
+                max_gap[var] = max(max_gap[var], i - last[var]);
+            }
+            last[var] = i;
+        }
+    }
+
+    vector<int> spans(vars+1, -1);
+    for(int v = 1; v <= vars; ++v) {
+        if(first[v] == -1) continue;
+
+        spans[v] = last[v] - first[v];
+        if(circular && spans[v] > 0) {
+            spans[v] = min(spans[v], c - max_gap[v]);
+        }
+    }
+
+    return spans;
+}
+
+
+/**
+ * Prints span statistics of a formula (total, average, median, and max span over the variables)
+ * 
+ * Params:
+ * - string label: printed before the statistics
+ * - int vars: the number of variables
+ * - vector<vector<int>> formula: the SAT formula
+ * - bool circular: uses circular spans (like findSpan()) if true
+*/
+void printSpanStats(string label, int vars, vector<vector<int>>& formula, bool circular) {
+    vector<int> spans = findAllSpans(vars, formula, circular);
+
+    vector<int> vals;
+    long long total = 0;
+    for(int v = 1; v <= vars; ++v) {
+        if(spans[v] < 0) continue;
+        vals.push_back(spans[v]);
+        total += spans[v];
+    }
+    if(vals.empty()) {
+        cout << label << ": no variables" << endl;
+        return;
+    }
+    sort(vals.begin(), vals.end());
+
+    double median = (vals.size() % 2) ? vals[vals.size()/2] : (vals[vals.size()/2 - 1] + vals[vals.size()/2]) / 2.0;
+
+    cout << label << (circular ? " (circular spans)" : " (linear spans)") << endl;
+    cout << "\tTotal Span: " << total << endl;
+    cout << "\tAvg Span: " << total * 1.0 / vals.size() << endl;
+    cout << "\tMedian Span: " << median << endl;
+    cout << "\tMax Span: " << vals.back() << endl;
+}
+
+
+/**
+ * Builds the variable to clause index (CSR format) used by the ordering heuristics
+ * var_clause_list[var_start[v] ... var_start[v+1]-1] are the clauses (0-indexed) that var v is in
+*/
+void ReorderFormula::buildIndex() {
+    buildOccurrenceIndex(formula, vars, false, var_start, var_clause_list);
+}
+
+
+/**
+ * Helper for cuthillMcKeeOrder(): BFS over the clause/variable incidence graph starting at a clause,
+ * appending clauses to order in the order they are visited. Neighbors are visited in increasing degree.
+ * 
+ * Params:
+ * - int start: clause to start from
+ * - vector<char>& visited: clauses already placed (updated)
+ * - vector<char>& expanded: vars already expanded (updated)
+ * - vector<int>& degree: degree of each clause (total occurrences of its vars)
+ * - vector<int>& order: visit order (appended to)
+*/
+void ReorderFormula::cuthillMcKeeBFS(int start, vector<char>& visited, vector<char>& expanded, vector<int>& degree, vector<int>& order) {
+    int head = order.size();
+    visited[start] = 1;
+    order.push_back(start);
+
+    vector<int> neighbors;
+    while(head < order.size()) {
+        int c = order[head++];
+
+        // Expand each var of this clause only once (keeps BFS linear in the number of literals)
+        neighbors.clear();
+        for(int lit : formula[c]) {
+            int var = abs(lit);
+            if(expanded[var]) continue;
+            expanded[var] = 1;
+
+            for(int i = var_start[var]; i < var_start[var+1]; ++i) {
+                int n = var_clause_list[i];
+                if(!visited[n]) {
+                    visited[n] = 1;
+                    neighbors.push_back(n);
+                }
+            }
+        }
+
+        // Lowest degree first
+        sort(neighbors.begin(), neighbors.end(), [&](int a, int b) {
+            return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+        });
+        for(int n : neighbors) order.push_back(n);
+    }
+}
+
+
+/**
+ * Orders clauses using (reverse) Cuthill-McKee on the clause/variable incidence graph
+ * Each connected component starts from a pseudo-peripheral clause (last clause reached by a BFS
+ * from the lowest degree clause)
+ * 
+ * Params:
+ * - bool reverse_order: reverses the final order (RCM), default true
+ * 
+ * Returns:
+ * - vector<int>: order[i] is the clause (0-indexed) placed on row i
+*/
+vector<int> ReorderFormula::cuthillMcKeeOrder(bool reverse_order) {
+    // Degree of a clause = number of (clause, var) neighbors
+    vector<int> degree(clauses, 0);
+    for(int c = 0; c < clauses; ++c) {
+        for(int lit : formula[c]) {
+            int var = abs(lit);
+            degree[c] += var_start[var+1] - var_start[var] - 1;
+        }
+    }
+
+    // Clauses by increasing degree, used to pick start of each component
+    vector<int> by_degree(clauses);
+    for(int c = 0; c < clauses; ++c) by_degree[c] = c;
+    sort(by_degree.begin(), by_degree.end(), [&](int a, int b) {
+        return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+    });
+
+    vector<int> order;
+    order.reserve(clauses);
+    vector<char> visited(clauses, 0), expanded(vars+1, 0);
+    vector<char> visited_probe(clauses, 0), expanded_probe(vars+1, 0);
+    vector<int> probe;
+
+    for(int s : by_degree) {
+        if(visited[s]) continue;
+
+        // Find a pseudo-peripheral start with a probing BFS
+        probe.clear();
+        cuthillMcKeeBFS(s, visited_probe, expanded_probe, degree, probe);
+        int start = probe.back();
+
+        cuthillMcKeeBFS(start, visited, expanded, degree, order);
+    }
+
+    if(reverse_order) reverse(order.begin(), order.end());
+    return order;
+}
+
+
+/**
+ * Helper that turns clause positions into an order (stable sort by position)
+*/
+vector<int> ReorderFormula::positionsToOrder(const vector<double>& pos) {
+    vector<int> order(clauses);
+    for(int c = 0; c < clauses; ++c) order[c] = c;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return pos[a] < pos[b];
+    });
+    return order;
+}
+
+
+/**
+ * Orders clauses by an approximate Fiedler vector of the clause/variable incidence graph
+ * Power iteration on the random walk operator (clause -> average of its vars -> average of their clauses),
+ * removing the constant component and normalizing every step
+ * 
+ * Params:
+ * - int iterations: number of power iterations (default 200)
+ * 
+ * Returns:
+ * - vector<int>: order[i] is the clause (0-indexed) placed on row i
+*/
+vector<int> ReorderFormula::spectralOrder(int iterations) {
+    // Start from the current order, which is usually already partially local
+    vector<double> x(clauses), var_x(vars+1, 0);
+    for(int c = 0; c < clauses; ++c) x[c] = c - (clauses - 1) / 2.0;
+
+    for(int it = 0; it < iterations; ++it) {
+        // Vars take the average of their clauses
+        for(int v = 1; v <= vars; ++v) {
+            int count = var_start[v+1] - var_start[v];
+            if(count == 0) continue;
+
+            double sum = 0;
+            for(int i = var_start[v]; i < var_start[v+1]; ++i) sum += x[var_clause_list[i]];
+            var_x[v] = sum / count;
+        }
+
+        // Clauses take the average of their vars
+        double mean = 0;
+        for(int c = 0; c < clauses; ++c) {
+            if(formula[c].empty()) continue;
+
+            double sum = 0;
+            for(int lit : formula[c]) sum += var_x[abs(lit)];
+            x[c] = sum / formula[c].size();
+            mean += x[c];
+        }
+        mean /= max(clauses, 1);
+
+        // Remove constant component, normalize
+        double norm = 0;
+        for(int c = 0; c < clauses; ++c) {
+            x[c] -= mean;
+            norm += x[c] * x[c];
+        }
+        norm = sqrt(norm);
+        if(norm == 0) break;
+        for(int c = 0; c < clauses; ++c) x[c] /= norm;
+    }
+
+    return positionsToOrder(x);
+}
+
+
+/**
+ * Orders clauses with the FORCE heuristic (clauses are nodes, variables are hyperedges)
+ * Every iteration, each var's center of gravity is the average position of its clauses, each clause
+ * moves to the average center of gravity of its vars, and the clauses are re-ranked by position.
+ * Keeps the order with the lowest total span.
+ * 
+ * Params:
+ * - int iterations: number of iterations (default 20)
+ * 
+ * Returns:
+ * - vector<int>: order[i] is the clause (0-indexed) placed on row i
+*/
+vector<int> ReorderFormula::forceOrder(int iterations) {
+    vector<int> order(clauses);
+    for(int c = 0; c < clauses; ++c) order[c] = c;
+
+    vector<int> best_order = order;
+    long long best_total = orderTotalSpan(order);
+
+    vector<double> pos(clauses), cog(vars+1, 0);
+    for(int it = 0; it < iterations; ++it) {
+        // Position of each clause is its rank in the current order
+        for(int i = 0; i < clauses; ++i) pos[order[i]] = i;
+
+        // Centers of gravity
+        for(int v = 1; v <= vars; ++v) {
+            int count = var_start[v+1] - var_start[v];
+            if(count == 0) continue;
+
+            double sum = 0;
+            for(int i = var_start[v]; i < var_start[v+1]; ++i) sum += pos[var_clause_list[i]];
+            cog[v] = sum / count;
+        }
+
+        // Move clauses
+        vector<double> new_pos(clauses);
+        for(int c = 0; c < clauses; ++c) {
+            if(formula[c].empty()) {
+                new_pos[c] = pos[c];
+                continue;
+            }
+
+            double sum = 0;
+            for(int lit : formula[c]) sum += cog[abs(lit)];
+            new_pos[c] = sum / formula[c].size();
+        }
+
+        order = positionsToOrder(new_pos);
+        long long total = orderTotalSpan(order);
+
+        if(debug) cout << "FORCE iteration " << it+1 << ": total span " << total << endl;
+
+        if(total < best_total) {
+            best_total = total;
+            best_order = order;
+        }
+    }
+
+    return best_order;
+}
+
+
+/**
+ * Helper that calculates total (linear) span of all vars if clauses were placed in this order
+*/
+long long ReorderFormula::orderTotalSpan(const vector<int>& order) {
+    vector<int> row(clauses);
+    for(int i = 0; i < clauses; ++i) row[order[i]] = i;
+
+    long long total = 0;
+    for(int v = 1; v <= vars; ++v) {
+        if(var_start[v] == var_start[v+1]) continue;
+
+        int lo = INT_MAX, hi = INT_MIN;
+        for(int i = var_start[v]; i < var_start[v+1]; ++i) {
+            lo = min(lo, row[var_clause_list[i]]);
+            hi = max(hi, row[var_clause_list[i]]);
+        }
+        total += hi - lo;
+    }
+    return total;
+}
+
+
+/**
+ * Applies a clause order, creating reordered_formula. Variables are also renumbered by their
+ * center of gravity in the new clause order, so neighboring columns share clauses.
+ * 
+ * Params:
+ * - vector<int> order: order[i] is the clause (0-indexed) placed on row i
+*/
+void ReorderFormula::applyOrder(const vector<int>& order) {
+    clause_order = order;
+
+    vector<int> row(clauses);
+    for(int i = 0; i < clauses; ++i) row[order[i]] = i;
+
+    // Center of gravity of each var (vars that don't appear go last)
+    vector<double> cog(vars+1, INT_MAX);
+    for(int v = 1; v <= vars; ++v) {
+        int count = var_start[v+1] - var_start[v];
+        if(count == 0) continue;
+
+        double sum = 0;
+        for(int i = var_start[v]; i < var_start[v+1]; ++i) sum += row[var_clause_list[i]];
+        cog[v] = sum / count;
+    }
+
+    new_to_old_var.assign(1, 0);
+    for(int v = 1; v <= vars; ++v) new_to_old_var.push_back(v);
+    stable_sort(new_to_old_var.begin() + 1, new_to_old_var.end(), [&](int a, int b) {
+        return cog[a] < cog[b];
+    });
+
+    old_to_new_var.assign(vars+1, 0);
+    for(int v = 1; v <= vars; ++v) old_to_new_var[new_to_old_var[v]] = v;
+
+    // Build reordered formula
+    reordered_formula.clear();
+    reordered_formula.reserve(clauses);
+    for(int c : order) {
+        vector<int> clause;
+        clause.reserve(formula[c].size());
+        for(int lit : formula[c]) {
+            int v = old_to_new_var[abs(lit)];
+            clause.push_back(lit > 0 ? v : -v);
+        }
+        reordered_formula.push_back(clause);
+    }
+}
+
+
+/**
+ * Reorders the formula with the given heuristic, printing span statistics before and after
+ * 
+ * Params:
+ * - string heur: {"cuthill-mckee", "reverse-cuthill-mckee", "spectral", "force"}
+ *   - "force" starts from the reverse Cuthill-McKee order
+ * 
+ * Returns:
+ * - bool: false if heuristic isn't supported
+ * - reordered_formula, clause_order, old_to_new_var, new_to_old_var are set
+*/
+bool ReorderFormula::reorder(string heur) {
+    vector<int> order;
+    if(heur == "cuthill-mckee") {
+        order = cuthillMcKeeOrder(false);
+    } else if(heur == "reverse-cuthill-mckee") {
+        order = cuthillMcKeeOrder(true);
+    } else if(heur == "spectral") {
+        order = spectralOrder();
+    } else if(heur == "force") {
+        // FORCE only refines, so give it a good starting order
+        ReorderFormula start(vars, formula);
+        start.applyOrder(start.cuthillMcKeeOrder(true));
+
+        ReorderFormula refine(vars, start.reordered_formula);
+        refine.debug = debug;
+        vector<int> refined = refine.forceOrder();
+
+        // Compose: refined is in terms of start's rows
+        for(int i : refined) order.push_back(start.clause_order[i]);
+    } else {
+        cout << "ERROR: can't support provided heur " << heur << endl;
+        return false;
+    }
+
+    applyOrder(order);
+
+    cout << "Reordering heur: " << heur << endl;
+    printSpanStats("Before", vars, formula, false);
+    printSpanStats("After", vars, reordered_formula, false);
+    printSpanStats("Before", vars, formula, true);
+    printSpanStats("After", vars, reordered_formula, true);
+    cout << endl;
+
+    return true;
+}
+
+
+/**
+ * Writes reordered formula to a file, with the variable mappings as comments
+ * 
+ * Params:
+ * - string outputFilename
+ * - string description: added to top of file as a comment (default - empty)
+*/
+void ReorderFormula::writeReordered(const string& outputFilename, const string& description) {
+    writeFormulaToFile(reordered_formula, vars, old_to_new_var, vars, clauses, outputFilename, description);
+}
+
+
+/**
+ * Resolves the number of threads to use (0 or less means use all hardware threads)
+*/
+int threadsToUse(int num_threads) {
+    if(num_threads > 0) return num_threads;
+    int hw = thread::hardware_concurrency();
+    return max(hw, 1);
 }
 
 /**
- * Returns k random variables given a number of variables
+ * Runs func(i) for every i in [0, n) across multiple threads
+ * Indices are handed out one at a time, so tasks of uneven size still balance out
  * 
  * Params:
- * - int vars: number of variables
- * - int k: size of set to return
- * 
- * Returns:
- * - unordered_set<int>: the k random variables
+ * - int n: number of tasks
+ * - int num_threads: number of threads (0 = all hardware threads)
+ * - func: the task, called with the task index
 */
-unordered_set<int> kRandomVariables(int vars, int k) {
-    unordered_set<int> result;
+void parallelFor(int n, int num_threads, const function<void(int)>& func) {
+    num_threads = min(threadsToUse(num_threads), max(n, 1));
 
-    while(result.size() != k) {
-        // Pick random variable
-        int r = (rand() % vars) + 1;
+    if(num_threads == 1) {
+        for(int i = 0; i < n; ++i) func(i);
+        return;
+    }
 
-        result.insert(r);
+    atomic<int> next(0);
+    vector<thread> workers;
+    for(int t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&]() {
+            for(int i = next++; i < n; i = next++) func(i);
+        });
     }
+    for(thread& w : workers) w.join();
+}
 
-    return result;
+
+/**
+ * Finds root of a var in the union-find forest (with path halving)
+*/
+int ComponentDecomposition::findRoot(vector<int>& parent, int v) {
+    while(parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
 }
 
 /**
- * Creates contiguous groups by number of unique vars in group
+ * Splits the formula into its connected components (vars are connected if they share a clause)
+ * Uses union-find over the vars of each clause, so it is near-linear in the number of literals
  * 
  * Params:
- * - max_vars: maximum number of unique variables in a group
+ * - bool remove_units: if true, first simplifies the formula (unit clauses and unipolar literals),
+ *   which often breaks it into more components
  * 
  * Returns:
- * - int: number of groups made
- * - group_to_clauses and clause_to_group class variables get set
+ * - int: number of components (-1 if simplifying found the formula UNSAT)
+ * - components and component_vars are set
 */
-int ContiguousPartition::createPartitionsBySize(int max_size) {
-    // Keep track of unique vars seen
-    unordered_set<int> vars_seen;
-
-    // Maintain group number
-    int curr_group = 0;
-
-    // Iterate through each clause
-    for(int c = 0; c < clauses; ++c) {
-        int curr_clause = c+1;
-
-        // Edge case
-        if(formula[c].size() > max_size) {
-            if(!vars_seen.empty()) {
-                vars_seen.clear();
-                ++curr_group;
+int ComponentDecomposition::decompose(bool remove_units) {
+    components.clear();
+    component_vars.clear();
+    unit_assignment.clear();
+
+    vector<vector<int>> work = formula;
+    if(remove_units) {
+        unit_assignment = simplify(vars, work);
+        for(const vector<int>& c : work) {
+            if(c.empty()) return num_components = -1;
+        }
+    }
+
+    // Union vars in the same clause
+    vector<int> parent(vars+1);
+    for(int v = 0; v <= vars; ++v) parent[v] = v;
+    for(const vector<int>& c : work) {
+        if(c.empty()) continue;
+        int root = findRoot(parent, abs(c[0]));
+        for(int i = 1; i < c.size(); ++i) {
+            int other = findRoot(parent, abs(c[i]));
+            if(other != root) {
+                parent[other] = root;
             }
-            group_to_clauses[curr_group].insert(curr_clause);
-            clause_to_group[curr_clause] = curr_group;
-            ++curr_group;
-            continue;
         }
+    }
 
-        // Iterate through each literal
-        for(int l : formula[c]) {
-            int var = abs(l);
-
-            // Mark as seen
-            vars_seen.insert(var);
-
-            // If over the limit
-            if(vars_seen.size() > max_size) {
-                // Reset
-                vars_seen.clear();
-                --c;
-                ++curr_group;
-                break;
-            }
+    // Give each root a component number, in order of first clause
+    vector<int> root_to_comp(vars+1, -1);
+    for(const vector<int>& c : work) {
+        if(c.empty()) continue;
+        int root = findRoot(parent, abs(c[0]));
+        if(root_to_comp[root] == -1) {
+            root_to_comp[root] = components.size();
+            components.push_back(Formula());
         }
+        components[root_to_comp[root]].formula.push_back(c);
+    }
 
-        // Assign clause
-        group_to_clauses[curr_group].insert(curr_clause);
-        clause_to_group[curr_clause] = curr_group;
+    // Renumber each component so its vars are 1..n
+    component_vars.resize(components.size());
+    for(int i = 0; i < components.size(); ++i) {
+        vector<int> old_to_new;
+        components[i].vars = renumberFormula(components[i].formula, old_to_new, component_vars[i]);
     }
 
-    // Return number of groups
-    return curr_group;
+    if(debug) printComponents();
 
+    return num_components = components.size();
 }
 
 /**
- * Evaluates groupings by seeing what number of vars activate 1 group, 2 groups, ...
- * and prints information about these results
+ * Prints the number of components and the size of the largest ones
 */
-void ContiguousPartition::evaluateGroupings() {
-    // Create map for mappings
-    unordered_map<int, int> mappings;
-    for(int i = 1; i < clauses; ++i) {
-        mappings[i] = clause_to_group[i];
-    }
-    unordered_map<int, set<int>> results = runGroupsExperiment(vars, formula, mappings);
-    
-    // printGroupsResults(results, group_to_clauses.size());
-
-    int max_i = group_to_clauses.size();
-    while(results[max_i].size() == 0) {
-        --max_i;
+void ComponentDecomposition::printComponents() {
+    vector<pair<int, int>> sizes;
+    for(int i = 0; i < components.size(); ++i) {
+        sizes.push_back(make_pair(components[i].vars, components[i].formula.size()));
     }
+    sort(sizes.rbegin(), sizes.rend());
 
-    cout << "Number of Groups: Number of Variables that Activate That Amount" << endl;
-    for(int i = 0; i <= max_i; ++i) {
-        // cout << i << ": " ;
-        cout << results[i].size() << endl;
+    cout << "Components: " << components.size() << endl;
+    if(unit_assignment.size()) cout << "Vars assigned while removing units: " << unit_assignment.size() << endl;
+    for(int i = 0; i < sizes.size() && i < 10; ++i) {
+        cout << "\t" << sizes[i].first << " vars, " << sizes[i].second << " clauses" << endl;
     }
+    if(sizes.size() > 10) cout << "\t... (" << sizes.size() - 10 << " more)" << endl;
+    cout << endl;
 }
 
 /**
- * Given a variable and a formula, figure out where it occurs in the formula.
- * Specifically, the mean clause number, and the standard deviation, the min clause num, max clause num
+ * Solves each component independently (in parallel) with the legacy solve(), and merges the models
+ * (decomposes first, without removing units, if decompose() wasn't called yet)
  * 
  * Params:
- * - int var: the variable to focus on
- * - vector<vector<int>> formula: the SAT formula
+ * - vector<int>& model: returned, model[v] is v or -v (size vars+1)
+ * - string heuristic: heuristic passed to solve()
+ * - bool cdcl: passed to solve()
+ * - int num_threads: 0 = all hardware threads
  * 
  * Returns:
- * - prints mean, standard deviation, min clause, max clause
+ * - bool: true if every component is SAT (formula is SAT)
 */
-void findVarMeanAndSDClause(int var, vector<vector<int>>& formula) {
-    // Keep track of the clauses this var occurs in
-    unordered_set<int> clauses;
-    // Keep track of the sum
-    int sum = 0;
-
-    // Keep track of min and max clauses
-    int min_clause = INT_MAX;
-    int max_clause = INT_MIN;
-
-    // Iterate through each clause
-    for(int i = 0; i < formula.size(); ++i) {
-        int c = i+1;
-        for(int lit : formula[i]) {
-            // If var in formula
-            if(abs(lit) == var) {
-                min_clause = min(min_clause, c);
-                max_clause = max(max_clause, c);
+bool ComponentDecomposition::solveComponents(vector<int>& model, string heuristic, bool cdcl, int num_threads) {
+    // Reuse an earlier decompose() (with its unit assignment and UNSAT result)
+    if(num_components == -2) decompose();
+    if(num_components < 0) return false;
+
+    int n = components.size();
+    vector<char> results(n, 0);
+    vector<unordered_set<int>> assignments(n);
+    vector<double> seconds(n, 0);
+    atomic<bool> unsat(false);
+
+    parallelFor(n, num_threads, [&](int i) {
+        // No need to keep going once any component is UNSAT
+        if(unsat) return;
+
+        auto start = chrono::high_resolution_clock::now();
+        vector<vector<int>> f = components[i].formula;
+        int counter = 0;
+        results[i] = solve(f, assignments[i], components[i].vars, heuristic, cdcl, false, counter);
+        seconds[i] = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+        if(!results[i]) unsat = true;
+    });
 
-                sum += c;
-                clauses.insert(c);
-                break;
-            }
+    if(debug) {
+        for(int i = 0; i < n; ++i) {
+            cout << "Component " << i << " (" << components[i].vars << " vars): ";
+            cout << (results[i] ? "SAT" : "UNSAT") << " in " << seconds[i] << " seconds" << endl;
         }
     }
 
-    // Find mean
-    float mean = (sum * 1.0) / (clauses.size() * 1.0);
+    if(unsat) return false;
 
-    // Find standard deviation
-    float tmp = 0;
-    for(int c : clauses) {
-        tmp += (c - mean) * (c - mean);
+    // Merge: default every var to true, then apply units and component models
+    model.assign(vars+1, 0);
+    for(int v = 1; v <= vars; ++v) model[v] = v;
+    for(int l : unit_assignment) model[abs(l)] = l;
+    for(int i = 0; i < n; ++i) {
+        for(int l : assignments[i]) {
+            int var = component_vars[i][abs(l)];
+            model[var] = (l > 0) ? var : -var;
+        }
     }
-    float sd = pow((tmp / (clauses.size() - 1.0)), 0.5);
-    
-
-    // Print
-    cout << "Var " << var << endl;
-    cout << "\tMean: " << mean << endl;
-    cout << "\tSD: " << sd << endl;
-    cout << "\tMin: " << min_clause << "\t\tMax: " << max_clause << endl;
-}
-
-/**
- * Identical to previous function, but finds stats for all variables
-*/
-void findAllMeanAndSdClauses(int total_vars, vector<vector<int>>& formula) {
-    // Keep track of the clauses each var occurs in
-    unordered_map<int, set<int>> var_to_clauses;
-
-    // Maintain min clause and max clause
-    unordered_map<int, int> var_to_min_clause;
-    unordered_map<int, int> var_to_max_clause;
-
-    // Keep track of sum of clauses for each var
-    unordered_map<int, int> var_to_sum;
-
-    // Fill in values
-    for(int i = 0; i < formula.size(); ++i) {
-        int c = i+1;
-        for(int lit : formula[i]) {
-            int v = abs(lit);
-            var_to_clauses[v].insert(c);
-
-            if(var_to_min_clause.count(v) == 0 || var_to_min_clause[v] > c) {
-                var_to_min_clause[v] = c;
-            }
 
-            if(var_to_max_clause.count(v) == 0 || var_to_max_clause[v] < c) {
-                var_to_max_clause[v] = c;
+    // Double check merged model against the original formula
+    for(const vector<int>& c : formula) {
+        bool satisfied = false;
+        for(int l : c) {
+            if(model[abs(l)] == l) {
+                satisfied = true;
+                break;
             }
-
-            var_to_sum[v] += c;
         }
-    }
-
-    // Calculate and print out stats for each var
-    for(int v = 1; v <= total_vars; ++v) {
-        // Find mean
-        float mean = (var_to_sum[v] * 1.0) / (var_to_clauses[v].size() * 1.0);
-
-        // Find standard deviation
-        float tmp = 0;
-        for(int c : var_to_clauses[v]) {
-            tmp += (c - mean) * (c - mean);
+        if(!satisfied) {
+            cout << "VALIDATION: FAILED (merged model doesn't satisfy the formula)" << endl;
+            return false;
         }
-        float sd = pow((tmp / (var_to_clauses[v].size() - 1.0)), 0.5);
-        
-
-        // Print
-        cout << "Var " << v << endl;
-        cout << "\tMean: " << mean << endl;
-        cout << "\tSD: " << sd << endl;
-        cout << "\tMin: " << var_to_min_clause[v] << "\t\tMax: " << var_to_max_clause[v] << endl;
     }
-}
 
+    return true;
+}
 
 /**
- * Uses most occurred heuristic to determine best var to remove
+ * Maps each component onto its own Architecture (in parallel)
+ * (decomposes first, without removing units, if decompose() wasn't called yet)
+ * Each component gets ones full-length columns and twos folded columns (2 lines each), where
+ * twos is roughly fold_fraction of its vars (rounded so both line sets are even)
  * 
  * Params:
- * - vector<vector<int>> formula: the SAT formula
- * - int vars: the number of variables
+ * - double fold_fraction: fraction of vars that get a folded column
+ * - string method: "prune", "lits_only", default = regular
+ * - bool descending: passed to implement
+ * - int num_threads: 0 = all hardware threads
  * 
  * Returns:
- * - int: the most occurring var
+ * - int: number of components that were mapped successfully
 */
-int heurFindMostOccurVar(vector<vector<int>>& formula, int vars) {
-    unordered_map<int, int> occur;
-    int max_var = 0, max_occur = -1;
-    for(vector<int> c : formula) {
-        for(int lit : c) {
-            int var = abs(lit);
-            ++occur[var];
+int ComponentDecomposition::mapComponents(double fold_fraction, string method, bool descending, int num_threads) {
+    // Reuse an earlier decompose()
+    if(num_components == -2) decompose();
+    if(num_components < 0) return 0;
+
+    int n = components.size();
+    vector<char> results(n, 0);
+
+    parallelFor(n, num_threads, [&](int i) {
+        int v = components[i].vars;
+        int twos = 2 * (int)(fold_fraction * v / 2);
+        int ones = 2*v - 2*twos;
+
+        vector<int> lines;
+        for(int j = 0; j < ones; ++j) lines.push_back(1);
+        for(int j = 0; j < twos; ++j) lines.push_back(2);
+
+        Architecture a(v, components[i].formula.size());
+        a.createEqualLines(lines);
+
+        bool result = false;
+        if(method == "prune") {
+            result = a.implementFormulaPrune(components[i].formula, v, descending);
+        } else if(method == "lits_only") {
+            result = a.implementFormulaLitsOnly(components[i].formula, v, descending);
+        } else {
+            result = a.implementFormula(components[i].formula, v, descending);
+        }
+        results[i] = result && a.validateImplement();
+    });
 
-            // Update
-            if(max_occur < occur[var]) {
-                max_occur = occur[var];
-                max_var = var;
-            }
+    int mapped = 0;
+    for(int i = 0; i < n; ++i) {
+        if(results[i]) ++mapped;
+        if(debug) {
+            cout << "Component " << i << " (" << components[i].vars << " vars, " << components[i].formula.size() << " clauses): ";
+            cout << (results[i] ? "mapped" : "FAILED") << endl;
         }
     }
-    return max_var;
+
+    return mapped;
 }
 
+
 /**
- * Uses most occurred heuristic to determine best var to remove
- * 
- * Params:
- * - vector<vector<int>> formula: the SAT formula
- * - int vars: the number of variables
- * 
- * Returns:
- * - int: the most occurring var
+ * Adds node v to the bucket for gain g
 */
-int heurFindMostOccurLit(vector<vector<int>>& formula, int vars) {
-    unordered_map<int, int> occur;
-    int max_lit = 0, max_occur = -1;
-    for(vector<int> c : formula) {
-        for(int lit : c) {
-            ++occur[lit];
+void GainBuckets::insert(int v, int g) {
+    int b = g + offset;
+    gain[v] = g;
+    prev[v] = -1;
+    next[v] = head[b];
+    if(head[b] != -1) prev[head[b]] = v;
+    head[b] = v;
+    in_bucket[v] = 1;
+    if(b > max_bucket) max_bucket = b;
+}
 
-            // Update
-            if(max_occur < occur[lit]) {
-                max_occur = occur[lit];
-                max_lit = lit;
-            }
-        }
-    }
-    return abs(max_lit);
+/**
+ * Removes node v from its bucket
+*/
+void GainBuckets::remove(int v) {
+    if(!in_bucket[v]) return;
+    if(prev[v] != -1) next[prev[v]] = next[v];
+    else head[gain[v] + offset] = next[v];
+    if(next[v] != -1) prev[next[v]] = prev[v];
+    in_bucket[v] = 0;
 }
 
+/**
+ * Moves node v to the bucket for gain g (only if it's in a bucket)
+*/
+void GainBuckets::update(int v, int g) {
+    if(!in_bucket[v] || gain[v] == g) return;
+    remove(v);
+    insert(v, g);
+}
 
 /**
- * Uses Jeroslow Wang Heuristic to determine best var
- * 
- * Params:
- * - vector<vector<int>> formula: the SAT formula
- * - int vars: the number of variables
- * 
- * Returns:
- * - int: the var to remove
+ * Returns a node with the highest gain (-1 if empty)
 */
-int heurFindJeroslowWang(vector<vector<int>>& formula, int vars) {
-    double max_score = INT_MIN;
-    int lit_with_max_score = -1;
+int GainBuckets::top() {
+    while(max_bucket >= 0 && head[max_bucket] == -1) --max_bucket;
+    return (max_bucket < 0) ? -1 : head[max_bucket];
+}
 
-    // Keep track of scores
-    unordered_map<int, double > score;
-    for(vector<int> c : formula) {
-        double clause_score = (1.0 / pow(2,  c.size()));
 
-        for(int l : c) {
-            // Update score
-            score[l] += clause_score;
+/**
+ * Max-heap of items 0..n-1 with changeable keys (ties go to the smaller item)
+*/
+void IndexedHeap::insert(int i, double k) {
+    key[i] = k;
+    pos[i] = heap.size();
+    heap.push_back(i);
+    siftUp(pos[i]);
+}
 
-            if(max_score < score[l]) {
-                max_score = score[l];
-                lit_with_max_score = l;
-            }
-        }
-    }
+void IndexedHeap::remove(int i) {
+    int p = pos[i];
+    int last = heap.back();
+    heap.pop_back();
+    pos[i] = -1;
+    if(last == i) return;
+
+    heap[p] = last;
+    pos[last] = p;
+    siftUp(p);
+    siftDown(pos[last]);
+}
 
+void IndexedHeap::update(int i, double k) {
+    if(pos[i] == -1) return;
+    double old = key[i];
+    key[i] = k;
+    if(k > old) siftUp(pos[i]);
+    else if(k < old) siftDown(pos[i]);
+}
 
-    // Return variable with max score
-    return abs(lit_with_max_score); 
+int IndexedHeap::top() {
+    return heap.empty() ? -1 : heap[0];
 }
 
 /**
- * Uses maximum occurrences in clauses of minimum size heuristic
+ * The k best items, best first (the heap is unchanged)
 */
-int heurFindMOM(vector<vector<int>>& formula, int vars) {
-    int min_size = INT_MAX;
-    unordered_map<int, set<int>> size_to_clauses;
-    for(int c = 0; c < formula.size(); ++c) {
-        int size = formula[c].size();
-        min_size = min(min_size, size);
-        size_to_clauses[size].insert(c);
-    }
+vector<int> IndexedHeap::topK(int k) {
+    vector<int> result;
+    vector<double> keys;
+    while(result.size() < k && !heap.empty()) {
+        int i = heap[0];
+        result.push_back(i);
+        keys.push_back(key[i]);
+        remove(i);
+    }
+    for(int j = 0; j < result.size(); ++j) insert(result[j], keys[j]);
+    return result;
+}
 
-    // Occurrences
-    unordered_map<int, int> occur;
-    int most_occurrences = INT_MIN;
-    int lit_with_most = -1;
-    for(int c : size_to_clauses[min_size]) {
-        for(int l : formula[c]) {
-            ++occur[l];
+void IndexedHeap::siftUp(int p) {
+    int i = heap[p];
+    while(p > 0) {
+        int parent = (p - 1) / 2;
+        if(!better(i, heap[parent])) break;
+        heap[p] = heap[parent];
+        pos[heap[p]] = p;
+        p = parent;
+    }
+    heap[p] = i;
+    pos[i] = p;
+}
 
-            if(most_occurrences < occur[l]) {
-                most_occurrences = occur[l];
-                lit_with_most = l;
+void IndexedHeap::siftDown(int p) {
+    int i = heap[p];
+    int n = heap.size();
+    while(2*p + 1 < n) {
+        int child = 2*p + 1;
+        if(child + 1 < n && better(heap[child+1], heap[child])) ++child;
+        if(!better(heap[child], i)) break;
+        heap[p] = heap[child];
+        pos[heap[p]] = p;
+        p = child;
+    }
+    heap[p] = i;
+    pos[i] = p;
+}
+
+
+/**
+ * Builds the CSR form of the graph (adj_start, adj) from edges, for graphs given as a map
+ * Only vars 1..vars are kept
+*/
+void Partition::buildCSR() {
+    adj_start.assign(vars+2, 0);
+    adj.clear();
+    max_degree = 0;
+
+    for(int v = 1; v <= vars; ++v) {
+        adj_start[v] = adj.size();
+        auto it = edges.find(v);
+        if(it != edges.end()) {
+            for(int n : it->second) {
+                if(n >= 1 && n <= vars && n != v) adj.push_back(n);
             }
         }
+        max_degree = max(max_degree, (int)adj.size() - adj_start[v]);
     }
+    adj_start[vars+1] = adj.size();
 
-    return abs(lit_with_most);
+    visited_epoch.assign(vars+1, 0);
+    bfs_depth.assign(vars+1, 0);
+    frontier.assign(vars, 0);
+    epoch = 0;
 }
 
 
 /**
- * Applies divide and conquer method with heuristics
- * Applies heur for one var, then removes, then applies next heuristic, and so on
+ * Fiduccia-Mattheyses refinement of a bisection (sides 0 and 1)
+ * Each pass moves every var at most once (highest gain first, keeping the sides balanced),
+ * then rolls back to the best balanced prefix. Gains are kept in bucket lists and updated
+ * per move in O(degree)
  * 
  * Params:
- * - Circuit c: the formula to operate on
- * - int k: number of variables to remove
- * - string heur: heuristic to use to select next var
- *      - (default) "max_occur_var": picks most occurring variable
- *      - "max_occur_lit": picks most occurring literal (as a variable)
- *          ex: -5 occurs 1 time and 5 occurs 6 times, and -10 occurs 5 times and 10 occurs 5 times
- *             max_occur_lit will choose 5, but max_occur_var will choose 10
- *      - "jeroslow-wang": uses jeroslow wang equation to pick next
- *      - "mom": picks var with maximum occurrences in minimum size clauses
- * - bool print: shows extra logs
+ * - vector<int>& part: side of each var (size vars+1), updated in place
+ * - int max_passes: max number of passes (stops earlier if a pass doesn't improve)
  * 
  * Returns:
- * - prints info about new formula
+ * - int: cost of the final partition (number of edges crossing it)
 */
-void divideAndConquerHeur(Circuit c, int k, string heur, bool print) {
-    // Keep track of formula
-    Formula f;
-    f.vars = c.vars;
-    f.formula = c.formula;
+int Partition::fmBisection(vector<int>& part, int max_passes) {
+    if(adj_start.size() != vars+2) buildCSR();
 
-    // Create queue of formulas to divide
-    queue<pair<Formula, int>> q; // formula to divide, and its id number
-    q.push(make_pair(f, 0));
-
-    // Keep track of ids
-    int id = 0;
+    int cost = 0;
+    for(int pass = 0; pass < max_passes; ++pass) {
+        // Number of neighbors of each var on each side
+        vector<int> conn[2] = {vector<int>(vars+1, 0), vector<int>(vars+1, 0)};
+        int size[2] = {0, 0};
+        cost = 0;
+        for(int v = 1; v <= vars; ++v) {
+            ++size[part[v]];
+            for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+                int u = adj[i];
+                ++conn[part[u]][v];
+                if(part[v] == 0 && part[u] == 1) ++cost;
+            }
+        }
 
-    // Keep track of how many vars have been removed from each problem
-    unordered_map<int, int> id_to_removals = { {0, 0} };
+        // Gain of moving v to the other side = (neighbors on other side) - (neighbors on same side)
+        GainBuckets buckets[2] = {GainBuckets(vars+1, max_degree), GainBuckets(vars+1, max_degree)};
+        for(int v = 1; v <= vars; ++v) {
+            int s = part[v];
+            buckets[s].insert(v, conn[1-s][v] - conn[s][v]);
+        }
 
-    // For each id, maintains its parent
-    unordered_map<int, int> parent_id;
+        int target = size[0];
+        int curr_cost = cost, best_cost = cost;
+        int best_len = 0;
+        vector<int> moves;
 
-    // For each id, maintain the lit removed to make it
-    unordered_map<int, int> id_to_lit_removed;
+        while(true) {
+            // Move from the bigger side, or the better side if balanced
+            int from;
+            if(size[0] > target) from = 0;
+            else if(size[0] < target) from = 1;
+            else {
+                int a = buckets[0].top(), b = buckets[1].top();
+                if(a == -1 && b == -1) break;
+                if(b == -1 || (a != -1 && buckets[0].gain[a] >= buckets[1].gain[b])) from = 0;
+                else from = 1;
+            }
 
-    int min_vars = INT_MAX;
+            int v = buckets[from].top();
+            if(v == -1) break;
+
+            // Move v (it stays locked for the rest of the pass)
+            curr_cost -= buckets[from].gain[v];
+            buckets[from].remove(v);
+            part[v] = 1 - from;
+            --size[from];
+            ++size[1-from];
+            moves.push_back(v);
+
+            // Update neighbor gains
+            for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+                int u = adj[i];
+                --conn[from][u];
+                ++conn[1-from][u];
+                int s = part[u];
+                buckets[s].update(u, conn[1-s][u] - conn[s][u]);
+            }
 
-    // Iterate until queue is empty
-    while(q.size()) {
-        pair<Formula, int> curr_pair = q.front();
-        q.pop();
-        Formula f = curr_pair.first;
-        int curr_id = curr_pair.second;
-        int curr_removals = id_to_removals[curr_id];
-
-       
-        if(print || curr_removals == k) {
-            cout << "\nCurr ID: " << curr_id << "  (" << curr_removals << " removals)" << endl;
-            if(print && curr_removals < k) {
-                cout << "\tVars: " << f.vars << endl;
-                cout << "\tClauses: " << f.formula.size() << endl << endl;
+            if(size[0] == target && curr_cost < best_cost) {
+                best_cost = curr_cost;
+                best_len = moves.size();
             }
         }
 
-        // If no more removals required
-        if(curr_removals == k) {
-            // Print required info
-            cout << "\tVars: " << f.vars << "  (" << f.vars * 100.0 / c.vars << "%)" << endl;
-            cout << "\tClauses: " << f.formula.size() << "  (" << f.formula.size() * 100.0 / c.clauses << "%)" << endl;
-
-            // Update min
-            min_vars = min(min_vars, f.vars);
-
-            continue;
+        // Roll back to best prefix
+        for(int i = moves.size()-1; i >= best_len; --i) {
+            part[moves[i]] = 1 - part[moves[i]];
         }
 
+        if(debug) cout << "FM pass " << pass << ": " << cost << " -> " << best_cost << endl;
 
-        // Pick var to remove using heuristics
-        int curr_var = -1;
-        // Jeroslow wang
-        if (heur == "jeroslow-wang") {
-            curr_var = heurFindJeroslowWang(f.formula, f.vars);
-        }
-        // Maximum occurrences in minimum size clauses
-        else if(heur == "mom") {
-            curr_var = heurFindMOM(f.formula, f.vars);
-        }
-        // Most occurring lit
-        else if (heur == "most_occur_lit") {
-            curr_var = heurFindMostOccurLit(f.formula, f.vars);
-        }
-        // Else: most occurring var
-        else {
-            curr_var = heurFindMostOccurVar(f.formula, f.vars);
-        }
+        cost = best_cost;
+        if(best_len == 0) break;
+    }
 
-        // Remove this variable
-        vector<Formula> result = runDivideExperimentSingleVar(f, curr_var);
+    return cost;
+}
 
-        // Create new ids if valid
-        int id_1 = -1, id_2 = -1;
-        if(result[0].vars != -1 && result[0].vars != 0) {
-            id_1 = id + 1;
-            ++id;
-            id_to_removals[id_1] = id_to_removals[curr_id] + 1;
-            parent_id[id_1] = curr_id;
-            id_to_lit_removed[id_1] = -1 * curr_var;
 
-            q.push(make_pair(result[0], id_1));
+/**
+ * Fiduccia-Mattheyses style refinement of a bisection with removed vars (sides 0 and 1, removed = 2)
+ * Each step swaps a var x on a side with a removed var r (x is removed, r takes its side),
+ * keeping the number of removed vars fixed. The best swap is found from bucket lists:
+ * the gain is (neighbors of x on the other side) - (neighbors of r on the other side)
+ * 
+ * Params:
+ * - vector<int>& part: side of each var, 2 if removed (size vars+1), updated in place
+ * - int max_passes: max number of passes (stops earlier if a pass doesn't improve)
+ * 
+ * Returns:
+ * - int: cost of the final partition (number of edges crossing it, ignoring removed vars)
+*/
+int Partition::fmSeparator(vector<int>& part, int max_passes) {
+    if(adj_start.size() != vars+2) buildCSR();
 
-            if(print) {
-                cout << "\tCreated ID " << id << " for removing " << -1 * curr_var << ", added to queue" << endl;
-            }
-        } else {
-            if(result[0].vars == -1) cout << "\tAfter removing " << -1 * curr_var << ", FAILURE" << endl;
-            else cout << "\tAfter removing " << -1 * curr_var << ", SUCCESS" << endl;
-            cout << "\t\tAssignment: " << curr_var << " ";
-            int parent = curr_id;
-            while(parent != 0) {
-                cout << id_to_lit_removed[parent] << " ";
-                parent = parent_id[parent];
+    int cost = 0;
+    for(int pass = 0; pass < max_passes; ++pass) {
+        vector<int> conn[2] = {vector<int>(vars+1, 0), vector<int>(vars+1, 0)};
+        cost = 0;
+        for(int v = 1; v <= vars; ++v) {
+            for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+                int u = adj[i];
+                if(part[u] < 2) ++conn[part[u]][v];
+                if(part[v] == 0 && part[u] == 1) ++cost;
             }
-            cout << endl;
         }
-        if(result[1].vars != -1 && result[1].vars != 0) {
-            id_2 = id + 1;
-            ++id;
-            id_to_removals[id_2] = id_to_removals[curr_id] + 1;
-            parent_id[id_2] = curr_id;
-            id_to_lit_removed[id_2] = curr_var;
 
-            q.push(make_pair(result[1], id_2));
+        // out[s]: vars on side s, keyed by neighbors on the other side (removing them saves that much)
+        // in[s]: removed vars, keyed by -(neighbors on the other side of s) (adding them to s costs that much)
+        GainBuckets out[2] = {GainBuckets(vars+1, max_degree), GainBuckets(vars+1, max_degree)};
+        GainBuckets in[2] = {GainBuckets(vars+1, max_degree), GainBuckets(vars+1, max_degree)};
+        for(int v = 1; v <= vars; ++v) {
+            if(part[v] < 2) {
+                out[part[v]].insert(v, conn[1-part[v]][v]);
+            } else {
+                in[0].insert(v, -conn[1][v]);
+                in[1].insert(v, -conn[0][v]);
+            }
+        }
 
-            if(print) {
-                cout << "\tCreated ID " << id << " for removing " << curr_var << ", added to queue" << endl;
+        // Refreshes the bucket keys of u after its neighbor counts changed
+        auto refresh = [&](int u) {
+            if(part[u] < 2) {
+                out[part[u]].update(u, conn[1-part[u]][u]);
+            } else {
+                in[0].update(u, -conn[1][u]);
+                in[1].update(u, -conn[0][u]);
             }
-        } else {
-            if(result[1].vars == -1) cout << "\tAfter removing " << curr_var << ", FAILURE" << endl;
-            else cout << "\tAfter removing " << curr_var << ", SUCCESS" << endl;
-            cout << "\t\tAssignment: " << curr_var << " ";
-            int parent = curr_id;
-            while(parent != 0) {
-                cout << id_to_lit_removed[parent] << " ";
-                parent = parent_id[parent];
+        };
+
+        // Moves v from side a to side b (2 = removed), updating neighbors
+        auto move = [&](int v, int a, int b) {
+            part[v] = b;
+            for(int i = adj_start[v]; i < adj_start[v+1]; ++i) {
+                int u = adj[i];
+                if(a < 2) --conn[a][u];
+                if(b < 2) ++conn[b][u];
+                refresh(u);
             }
-            cout << endl;
+        };
+
+        vector<char> locked(vars+1, 0);
+        int curr_cost = cost, best_cost = cost;
+        int best_len = 0;
+        vector<pair<int, int>> moves; // (x, r)
+
+        while(true) {
+            // Pick the side with the best swap
+            int best_s = -1, best_gain = 0;
+            for(int s = 0; s < 2; ++s) {
+                int x = out[s].top(), r = in[s].top();
+                if(x == -1 || r == -1) continue;
+                int g = out[s].gain[x] + in[s].gain[r];
+                if(best_s == -1 || g > best_gain) {
+                    best_s = s;
+                    best_gain = g;
+                }
+            }
+            if(best_s == -1) break;
+
+            int s = best_s;
+            int x = out[s].top(), r = in[s].top();
+
+            // x is removed (and can't be picked as x again this pass)
+            out[s].remove(x);
+            locked[x] = 1;
+            move(x, s, 2);
+            in[0].insert(x, -conn[1][x]);
+            in[1].insert(x, -conn[0][x]);
+
+            // r takes x's side
+            in[0].remove(r);
+            in[1].remove(r);
+            move(r, 2, s);
+            if(!locked[r]) out[s].insert(r, conn[1-s][r]);
+
+            curr_cost -= best_gain;
+            moves.push_back(make_pair(x, r));
+
+            if(curr_cost < best_cost) {
+                best_cost = curr_cost;
+                best_len = moves.size();
+            }
+        }
+
+        // Roll back to best prefix
+        for(int i = moves.size()-1; i >= best_len; --i) {
+            int x = moves[i].first, r = moves[i].second;
+            part[x] = part[r];
+            part[r] = 2;
         }
+
+        if(debug) cout << "FM pass " << pass << ": " << cost << " -> " << best_cost << endl;
+
+        cost = best_cost;
+        if(best_len == 0) break;
     }
 
-    // Print min
-    cout << "\n\nMin Vars: " << min_vars << "  (" << min_vars * 100.0 / c.vars << "%)\n";
+    return cost;
 }
 
+
 /**
-* Calculates heuristic list (ex: list of most occurring to least occurring variables)
-*
-* Params:
-* - heur: {"occurrences", "balance"}
-* - formula: the SAT formula
-* - vars: the number of variables
-* 
-* Returns:
-* - vector<int>: the heuristic list, in descending order
+ * Runs seeded restarts of the FM partitioners in parallel and keeps the best partition
+ * Each restart has its own random initial partition and state, and only reads the shared CSR graph
+ * 
+ * Params:
+ * - int restarts: number of restarts (at least 1 is run)
+ * - set<int>& removed: returns the removed vars of the best partition (if d > 0)
+ * - int d: number of vars to remove (0 = plain bisection like kernighanLinAlg, else like nodeKLAlg1)
+ * - int num_threads: 0 = all hardware threads
+ * - unsigned seed: restart r uses seed + r
+ * - string curve_file: if not empty, writes the cost-vs-time curve to this CSV file
+ * 
+ * Returns:
+ * - vector<set<int>>: a vector of size 2, representing vars of each partition
+ * - restart_curve has (seconds, best cost so far) after each restart finishes
 */
-vector<int> calculateHeurList(string heur, vector<vector<int>>& formula, int vars) {
-    // Maintain map from the var to the heuristic, use a vector
-    vector<int> var_to_heur(vars+1, 0);
+vector<set<int>> Partition::multiStartPartition(int restarts, set<int>& removed, int d, int num_threads, unsigned seed, string curve_file) {
+    if(adj_start.size() != vars+2) buildCSR();
+    restarts = max(restarts, 1);
+
+    vector<vector<int>> parts(restarts);
+    vector<int> costs(restarts, INT_MAX);
+    vector<pair<double, int>> finished; // (seconds, cost)
+    mutex finished_mutex;
+
+    auto start = chrono::high_resolution_clock::now();
+    parallelFor(restarts, num_threads, [&](int r) {
+        // Random initial partition (same layout as kernighanLinAlg / nodeKLAlg1)
+        vector<int> orderings;
+        for(int v = 1; v <= vars; ++v) orderings.push_back(v);
+        mt19937 g(seed + r);
+        shuffle(orderings.begin(), orderings.end(), g);
 
-    // Final result
-    vector<int> result;
+        vector<int> part(vars+1, 0);
+        int half = (vars - d) / 2;
+        for(int i = half; i < vars; ++i) part[orderings[i]] = (i < vars - d) ? 1 : 2;
 
-    // Most occurrences
-    if(heur == "occurrences") {
-        // Iterate through formula, adding occurrences
-        for(vector<int> clause : formula) {
-            for(int lit : clause) {
-                ++var_to_heur[abs(lit)];
+        costs[r] = (d > 0) ? fmSeparator(part) : fmBisection(part);
+        parts[r] = part;
+
+        double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        lock_guard<mutex> lock(finished_mutex);
+        finished.push_back(make_pair(seconds, costs[r]));
+    });
+
+    // Best cost so far, in the order restarts finished
+    sort(finished.begin(), finished.end());
+    restart_curve.clear();
+    int best_so_far = INT_MAX;
+    for(pair<double, int> f : finished) {
+        best_so_far = min(best_so_far, f.second);
+        restart_curve.push_back(make_pair(f.first, best_so_far));
+    }
+
+    if(curve_file != "") {
+        ofstream out(curve_file);
+        if(!out.is_open()) {
+            cout << "ERROR: could not open " << curve_file << endl;
+        } else {
+            out << "restarts,seconds,best_cost" << endl;
+            for(int i = 0; i < restart_curve.size(); ++i) {
+                out << i+1 << "," << restart_curve[i].first << "," << restart_curve[i].second << endl;
             }
         }
+    }
 
-        // Add to priority queue
-        priority_queue<pair<int, int>> pq;
-        for(int var = 1; var < var_to_heur.size(); ++var) {
-            pq.push(make_pair(var_to_heur[var], var));
+    if(debug) {
+        cout << "Restarts: Seconds, Best Cost" << endl;
+        for(int i = 0; i < restart_curve.size(); ++i) {
+            cout << i+1 << ": " << restart_curve[i].first << ", " << restart_curve[i].second << endl;
         }
+    }
 
-        // Remove from queue to add to result
-        while(pq.size()) {
-            pair<int, int> p = pq.top();
-            pq.pop();
-
-            result.push_back(p.second);
-        }
+    // Best restart
+    int best = min_element(costs.begin(), costs.end()) - costs.begin();
+    vector<set<int>> partitions(2);
+    removed.clear();
+    for(int v = 1; v <= vars; ++v) {
+        if(parts[best][v] == 2) removed.insert(v);
+        else partitions[parts[best][v]].insert(v);
     }
 
-    return result;
+    cout << "Best Cost: " << costs[best] << " (of " << restarts << " restarts)" << endl << endl;
+
+    return partitions;
 }
 
 
+
 /**
-* Given an assignments filename, parses into set
+ * Evaluates n random assignments bit-sliced: bit j of a var's word is the var's value in assignment j,
+ * so one OR over a clause's literal words (complemented for negative literals) evaluates the clause in
+ * 64 assignments at once. Each pass handles a block of 4 words (256 assignments), and blocks are split over threads
+ * Bits come from counterRandom(seed, ...), so the results don't depend on the number of threads
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - long long n: number of random assignments
+ * - long long& total_unsatisfied: returns the unsatisfied clauses summed over all assignments
+ * - long long& solutions: returns the number of assignments that satisfy every clause
+ * - bool count_unsatisfied: if false, a block stops once every assignment in it has an unsatisfied clause
+ *   (total_unsatisfied is then a lower bound)
+ * - unsigned long long seed: seed for the random assignments
+ * - int num_threads: 0 for all hardware threads
 */
-unordered_set<int> parseAssignmentsFile(string filename, int& propagations) {
-    unordered_set<int> assignments;
-    ifstream inFile(filename);
-    if (inFile.is_open()) {
-        string line;
-        // Read the first line to get the number of propagations
-        if (getline(inFile, line)) {
-            istringstream iss(line);
-            string keyword;
-            iss >> keyword; // Read "Propagations:"
-            iss >> propagations;
-        } else {
-            cerr << "Error reading file: " << filename << endl;
-            return assignments;
-        }
+void evaluateRandomAssignments(int vars, vector<vector<int>>& formula, long long n, long long& total_unsatisfied, long long& solutions, bool count_unsatisfied, unsigned long long seed, int num_threads) {
+    const int W = 4; // words per block
 
-        // Read the second line to get the assignments
-        if (getline(inFile, line)) {
-            istringstream iss(line);
-            int num;
-            while (iss >> num) {
-                assignments.insert(num);
-            }
-        } else {
-            cerr << "Error reading file: " << filename << endl;
-            return assignments;
+    // Flattened clauses, literal l as 2|l| + (l < 0) (vars past vars are never true, so they're dropped)
+    vector<int> clause_start(1, 0);
+    vector<int> lits;
+    for(const vector<int>& c : formula) {
+        for(int l : c) {
+            if(abs(l) <= vars) lits.push_back(2*abs(l) + (l < 0));
         }
-        // cout << "File parsed successfully: " << filename << endl;
-    } else {
-        cerr << "Error opening file: " << filename << endl;
+        clause_start.push_back(lits.size());
     }
-    inFile.close();
-    return assignments;
-}
 
-/**
-* Given an assignment, simplifies the formula by setting those assignments
-* Does NOT do unit propagation
-*/
-vector<vector<int>> assign(vector<vector<int>>& formula, unordered_set<int> assignments) {
-    // Create new formula
-    vector<vector<int>> new_formula;
+    long long blocks = (n + 64*W - 1) / (64*W);
+    int threads = min((long long)threadsToUse(num_threads), max(blocks, 1LL));
+    vector<long long> thread_unsatisfied(threads, 0), thread_solutions(threads, 0);
 
-    for(vector<int> c : formula) {
-        bool skip = false;
-        vector<int> new_clause;
-        for(int lit : c) {
-            // If skip
-            if(assignments.count(lit)) {
-                skip = true;
-                break;
+    parallelFor(threads, threads, [&](int t) {
+        // words[l*W + k]: literal l's values in word k of the block
+        vector<unsigned long long> words(2*(vars+1)*W, 0);
+
+        for(long long b = t; b < blocks; b += threads) {
+            unsigned long long mask[W];
+            for(int k = 0; k < W; ++k) {
+                long long left = n - (b*W + k) * 64;
+                mask[k] = left >= 64 ? ~0ULL : (left <= 0 ? 0 : (1ULL << left) - 1);
+            }
+            for(int v = 1; v <= vars; ++v) {
+                for(int k = 0; k < W; ++k) {
+                    unsigned long long r = counterRandom(seed, (unsigned long long)(b*W + k) * vars + v);
+                    words[2*v*W + k] = r;
+                    words[(2*v+1)*W + k] = ~r;
+                }
             }
 
-            // Else, add to new clause if needed
-            if(assignments.count(lit * -1) == 0) new_clause.push_back(lit);
+            unsigned long long any_unsatisfied[W] = {0};
+            long long unsatisfied = 0;
+            for(int c = 0; c + 1 < clause_start.size(); ++c) {
+                unsigned long long sat[W] = {0};
+                for(int i = clause_start[c]; i < clause_start[c+1]; ++i) {
+                    const unsigned long long* w = &words[lits[i]*W];
+                    for(int k = 0; k < W; ++k) sat[k] |= w[k];
+                }
+
+                bool all_unsatisfied = true;
+                for(int k = 0; k < W; ++k) {
+                    unsigned long long u = ~sat[k] & mask[k];
+                    unsatisfied += __builtin_popcountll(u);
+                    any_unsatisfied[k] |= u;
+                    all_unsatisfied = all_unsatisfied && any_unsatisfied[k] == mask[k];
+                }
+                if(!count_unsatisfied && all_unsatisfied) break;
+            }
+
+            thread_unsatisfied[t] += unsatisfied;
+            for(int k = 0; k < W; ++k) thread_solutions[t] += __builtin_popcountll(~any_unsatisfied[k] & mask[k]);
         }
+    });
 
-        if(!skip && new_clause.size()) new_formula.push_back(new_clause);
+    total_unsatisfied = 0;
+    solutions = 0;
+    for(int t = 0; t < threads; ++t) {
+        total_unsatisfied += thread_unsatisfied[t];
+        solutions += thread_solutions[t];
     }
+}
 
-    return new_formula;
+/**
+ * Bit-sliced version of unsatisfiedAndSolutionsMetric (old_funcs): average unsatisfied clauses
+ * and % of solutions over n random assignments
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - long long n: number of random samples to take
+ * - double& unsatisfiedAvg: returns the average number of unsatisfied clauses
+ * - double& solutionsPercent: returns the % of samples that are solutions
+ * - unsigned long long seed: seed for the random assignments
+ * - int num_threads: 0 for all hardware threads
+*/
+void unsatisfiedAndSolutionsMetricBits(int vars, vector<vector<int>>& formula, long long n, double& unsatisfiedAvg, double& solutionsPercent, unsigned long long seed, int num_threads) {
+    long long total_unsatisfied = 0, solutions = 0;
+    evaluateRandomAssignments(vars, formula, n, total_unsatisfied, solutions, true, seed, num_threads);
+
+    unsatisfiedAvg = (total_unsatisfied * 1.0) / (n * 1.0);
+    solutionsPercent = (solutions * 100.0) / (n * 1.0);
 }
 
-/*
-* Parses heuristic list file from minisat_experiments/
+/**
+ * Bit-sliced version of solutionsMetric (old_funcs): % of n random assignments that are solutions
+ * (stops evaluating a block once all of its assignments have an unsatisfied clause)
 */
-vector<int> parseHeurListFile(string filename, int& propagations) {
-    vector<int> heuristicList;
-    ifstream file(filename);
-    string line;
+float solutionsMetricBits(int vars, vector<vector<int>>& formula, long long n, unsigned long long seed, int num_threads) {
+    long long total_unsatisfied = 0, solutions = 0;
+    evaluateRandomAssignments(vars, formula, n, total_unsatisfied, solutions, false, seed, num_threads);
 
-    if (file.is_open()) {
-        // Read the heuristic list
-        while (getline(file, line)) {
-            if (line.empty()) {
-                // Empty line encountered, stop reading the heuristic list
-                break;
+    return (solutions * 100.0) / (n * 1.0);
+}
+
+
+
+/**
+ * Computes the per-var statistics in one pass: each thread takes a contiguous chunk of clauses and
+ * records counts, first/last clause and largest gap between clauses for every var, and the chunks are merged by var
+ * Each chunk has its own per-var arrays, so there are at most 8 chunks (and at least 4096 clauses per chunk)
+ * 
+ * Params:
+ * - int v: number of vars
+ * - vector<vector<int>>& formula: the SAT formula
+ * - int num_threads: 0 for all hardware threads
+*/
+FormulaMetrics::FormulaMetrics(int v, vector<vector<int>>& formula, int num_threads) {
+    vars = v;
+    clauses = formula.size();
+
+    const int max_chunks = 8, min_chunk_clauses = 4096;
+    int chunks = max(1, min({threadsToUse(num_threads), max_chunks, clauses / min_chunk_clauses}));
+    vector<vector<int>> pos(chunks), neg(chunks), first(chunks), last(chunks), gap(chunks);
+    vector<long long> chunk_literals(chunks, 0);
+
+    parallelFor(chunks, chunks, [&](int t) {
+        pos[t].assign(vars+1, 0);
+        neg[t].assign(vars+1, 0);
+        first[t].assign(vars+1, -1);
+        last[t].assign(vars+1, -1);
+        gap[t].assign(vars+1, 0);
+
+        int begin = (long long)clauses * t / chunks;
+        int end = (long long)clauses * (t+1) / chunks;
+        for(int i = begin; i < end; ++i) {
+            for(int lit : formula[i]) {
+                int var = abs(lit);
+                if(var > vars) continue;
+                ++chunk_literals[t];
+                if(lit > 0) ++pos[t][var];
+                else ++neg[t][var];
+
+                // Skip var appearing twice in the same clause
+                if(last[t][var] == i) continue;
+                if(first[t][var] == -1) first[t][var] = i;
+                else gap[t][var] = max(gap[t][var], i - last[t][var]);
+                last[t][var] = i;
             }
-            heuristicList.push_back(stoi(line));
         }
-
-        // Read the line containing the number of propagations
-        if (getline(file, line)) {
-            size_t pos = line.find(':');
-            if (pos != string::npos) {
-                propagations = stoi(line.substr(pos + 1));
+    });
+
+    literals = 0;
+    for(long long n : chunk_literals) literals += n;
+
+    // Merge the chunks in order (gaps can also cross chunk boundaries)
+    positive.assign(vars+1, 0);
+    negative.assign(vars+1, 0);
+    spans.assign(vars+1, -1);
+    int merge_chunks = max(1, min(threadsToUse(num_threads), vars));
+    parallelFor(merge_chunks, merge_chunks, [&](int t) {
+        int begin = 1 + (long long)vars * t / merge_chunks;
+        int end = 1 + (long long)vars * (t+1) / merge_chunks;
+        for(int var = begin; var < end; ++var) {
+            int var_first = -1, var_last = -1, max_gap = 0;
+            for(int k = 0; k < chunks; ++k) {
+                positive[var] += pos[k][var];
+                negative[var] += neg[k][var];
+                if(first[k][var] == -1) continue;
+                if(var_first == -1) var_first = first[k][var];
+                else max_gap = max(max_gap, first[k][var] - var_last);
+                max_gap = max(max_gap, gap[k][var]);
+                var_last = last[k][var];
             }
-        } else {
-            cerr << "Error: File format incorrect. Expected propagations." << endl;
-            return heuristicList; // Return heuristic list read so far
+            if(var_first == -1) continue;
+
+            // Circular span: the largest gap between consecutive clauses can be left out instead
+            spans[var] = var_last - var_first;
+            if(spans[var] > 0) spans[var] = min(spans[var], clauses - max_gap);
         }
+    });
 
-        file.close();
-    } else {
-        cerr << "Error: Unable to open file " << filename << endl;
-    }
+    summarize();
+}
 
-    return heuristicList;
+/**
+ * Computes the summary metrics from the per-var arrays, with the denominators of the old_funcs metrics:
+ * averages and SD divide by vars, and only appearing vars add to the SD sum (sdOccurrencesMetric)
+ * Occurrence and balance stats are over the appearing vars; span stats are over every var, so a var
+ * that doesn't appear adds -1 (findSpan()) to avg_span and median_span
+ * Differences from old_funcs:
+ * - medians are the middle value for an odd count (the old ones average vals[n/2-1] and vals[n/2])
+ * - median_balance is taken over sorted balances (medianBalanceMetric doesn't sort)
+ * - unipolar counts every var (unipolarityMetric loops i < vars and skips the last one)
+*/
+void FormulaMetrics::summarize() {
+    vector<int> occ_vals, span_vals, balance_vals;
+    long long occ_total = 0, span_total = 0, balance_total = 0;
+    unipolar = 0;
+    for(int v = 1; v <= vars; ++v) {
+        span_vals.push_back(spans[v]);
+        span_total += spans[v];
+        if(spans[v] < 0) continue;
+        int occ = positive[v] + negative[v];
+        if(positive[v] == 0 || negative[v] == 0) ++unipolar;
+        occ_vals.push_back(occ);
+        balance_vals.push_back(positive[v] - negative[v]);
+        occ_total += occ;
+        balance_total += positive[v] - negative[v];
+    }
+    appearing = occ_vals.size();
+
+    auto median = [](vector<int>& vals) {
+        if(vals.empty()) return 0.0;
+        sort(vals.begin(), vals.end());
+        int n = vals.size();
+        return (n % 2) ? (double)vals[n/2] : (vals[n/2 - 1] + vals[n/2]) / 2.0;
+    };
+
+    int n = max(vars, 1);
+    avg_occurrences = occ_total * 1.0 / n;
+    avg_span = span_total * 1.0 / n;
+    avg_balance = balance_total * 1.0 / n;
+
+    double sum = 0;
+    for(int occ : occ_vals) sum += (occ - avg_occurrences) * (occ - avg_occurrences);
+    sd_occurrences = sqrt(sum / n);
+
+    median_occurrences = median(occ_vals);
+    median_span = median(span_vals);
+    median_balance = median(balance_vals);
+
+    // Sorted by median()
+    max_occurrences = occ_vals.empty() ? 0 : occ_vals.back();
+    max_span = span_vals.empty() ? 0 : max(0, span_vals.back());
+    max_balance = balance_vals.empty() ? 0 : max(0, balance_vals.back());
+    min_balance = balance_vals.empty() ? 0 : min(0, balance_vals.front());
 }
 
-/*
-* Compares two heuristic lists, and returns a score, given a comparison metric
-* metrics: "index diff MSE", "index diff"
+// Column names matching csvRow()
+string FormulaMetrics::csvHeader() {
+    return "vars,clauses,literals,appearing,unipolar,max_occurrences,avg_occurrences,sd_occurrences,median_occurrences,"
+           "max_span,avg_span,median_span,max_balance,min_balance,avg_balance,median_balance";
+}
+
+// Summary metrics as one CSV row (without the file name)
+string FormulaMetrics::csvRow() const {
+    ostringstream row;
+    row << vars << "," << clauses << "," << literals << "," << appearing << "," << unipolar << ","
+        << max_occurrences << "," << avg_occurrences << "," << sd_occurrences << "," << median_occurrences << ","
+        << max_span << "," << avg_span << "," << median_span << ","
+        << max_balance << "," << min_balance << "," << avg_balance << "," << median_balance;
+    return row.str();
+}
+
+/**
+ * Computes the formula metrics of every .cnf file in a folder and writes one row per formula
+ * (formulas are parsed one at a time, and the pass over each one runs in parallel)
+ * 
+ * Params:
+ * - string input_folder: folder with the .cnf files (ex: "../SAT2017/")
+ * - string csv_file: output file
+ * - int num_threads: 0 for all hardware threads
+ * 
+ * Returns:
+ * - int: number of formulas written
 */
-int compareHeurLists(const vector<int> l1, const vector<int> l2, string metric) {
-    int score = 0;
+int runFormulaMetrics(string input_folder, string csv_file, int num_threads) {
+    vector<string> filenames = listSnapshotFiles(input_folder, "", ".cnf");
 
-    // Map each value in l2 to its index
-    unordered_map<int, int> l2_index;
-    for(int i = 0; i < l2.size(); ++i) {
-        l2_index[l2[i]] = i;
+    ofstream out(csv_file);
+    if(!out.is_open()) {
+        cout << "ERROR: could not open " << csv_file << endl;
+        return 0;
     }
+    out << "file," << FormulaMetrics::csvHeader() << endl;
 
-    // Find score
-    for(int i = 0; i < l1.size(); ++i) {
-        int diff = abs(i - l2_index[l1[i]]);
+    for(string filename : filenames) {
+        vector<vector<int>> formula;
+        int v = 0, c = 0;
+        parse(input_folder + filename, formula, v, c);
 
-        // mean square of differences of indices
-        if(metric == "index diff MSE") {
-            score += (diff * diff);
-        }
-        // sum up differences of indices without squaring
-        else if(metric == "index diff") {
-            score += diff;
-        }
+        FormulaMetrics metrics(v, formula, num_threads);
+        out << filename << "," << metrics.csvRow() << endl;
     }
 
-    return score;
+    return filenames.size();
 }
-
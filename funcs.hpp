@@ -6,6 +6,9 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
 
 using namespace std;
 
@@ -23,7 +26,68 @@ void updateFormulaWithLiteral(vector<vector<int>>& formula, int lit);
 unordered_set<int> simplify(int vars, vector<vector<int>>& formula, bool method1=false, bool print=false);
 int renumberFormula(vector<vector<int>>& formula);
 int renumberFormula(vector<vector<int>>& formula, unordered_map<int, int>& m);
-void writeFormulaToFile(vector<vector<int>>& formula, int vars, unordered_map<int, int> assignments, int old_vars, int old_clauses, string outputFilename, string description="");
+int renumberFormula(vector<vector<int>>& formula, vector<int>& old_to_new, vector<int>& new_to_old);
+void buildOccurrenceIndex(const vector<vector<int>>& formula, int vars, bool by_literal, vector<int>& start, vector<int>& list, bool unique=false);
+void writeFormulaToFile(vector<vector<int>>& formula, int vars, const vector<int>& assignments, int old_vars, int old_clauses, const string& outputFilename, const string& description="", bool binary=false);
+void writeFormulaToFileOld(vector<vector<int>>& formula, int vars, const vector<int>& assignments, int old_vars, int old_clauses, string outputFilename, string description="");
+void writeFormulaToBinaryFile(vector<vector<int>>& formula, int vars, const string& outputFilename);
+bool parseBinaryFormula(const string& filename, vector<vector<int>>& formula, int& v, int& c);
+void benchmarkFormulaWriters(vector<vector<int>>& formula, int vars, const string& outputFilename, int trials=3);
+
+// Buffered writer for CNF files: integers are formatted by hand into a large buffer,
+// which is flushed to the file in big chunks
+class CNFWriter {
+public:
+    FILE* file;
+    string name;
+    vector<char> buffer;
+    size_t pos; // number of bytes currently in buffer
+    bool failed; // a write failed (reported once, later writes are dropped)
+
+    CNFWriter(const string& filename, size_t buffer_size = 1 << 22);
+    ~CNFWriter();
+
+    // Owns the file
+    CNFWriter(const CNFWriter&) = delete;
+    CNFWriter& operator=(const CNFWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    void writeChar(char c);
+    void writeInt(int n);
+    void writeString(const string& s);
+    void writeRaw(const void* data, size_t bytes);
+    void flush();
+    void writeFile(const void* data, size_t bytes);
+};
+
+// Buffered reader for CNF files: reads clauses one at a time, so the formula
+// doesn't have to fit in memory
+class CNFReader {
+public:
+    FILE* file;
+    vector<char> buffer;
+    size_t pos; // next byte in buffer
+    size_t len; // number of bytes currently in buffer
+    bool done;
+    bool malformed; // set when something that isn't a literal is found
+    int clauses_read; // clauses returned so far
+
+    // From the "p cnf" line (0 until it's read)
+    int vars;
+    int clauses;
+
+    CNFReader(const string& filename, size_t buffer_size = 1 << 22);
+    ~CNFReader();
+
+    // Owns the file
+    CNFReader(const CNFReader&) = delete;
+    CNFReader& operator=(const CNFReader&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    int nextChar();
+    void skipLine();
+    bool nextClause(vector<int>& clause);
+};
 
 int areVarsDisjoint(vector<vector<int>>& formula, int var1, int var2);
 int areVarsDisjoint(map<int, set<int>>& lit_clauses, int var1, int var2);
@@ -207,6 +271,63 @@ public:
     Node(int v) { var = v; }
 }; */
 
+// Bucket lists keyed by gain for Fiduccia-Mattheyses refinement (O(1) insert/remove/update)
+class GainBuckets {
+public:
+    int offset;
+    int max_bucket;
+
+    // head[g + offset] is the first node with gain g (-1 if empty)
+    vector<int> head;
+    // Doubly linked lists through the nodes
+    vector<int> next;
+    vector<int> prev;
+    vector<int> gain;
+    vector<char> in_bucket;
+
+    // Constructor (nodes are 0..num_nodes-1, gains are in [-max_gain, max_gain])
+    GainBuckets(int num_nodes, int max_gain) {
+        offset = max_gain;
+        max_bucket = -1;
+        head.assign(2*max_gain + 1, -1);
+        next.assign(num_nodes, -1);
+        prev.assign(num_nodes, -1);
+        gain.assign(num_nodes, 0);
+        in_bucket.assign(num_nodes, 0);
+    };
+
+    void insert(int v, int g);
+    void remove(int v);
+    void update(int v, int g);
+    int top();
+};
+
+// Max-heap of items 0..n-1 keyed by double scores, with position lookup so keys can change
+class IndexedHeap {
+public:
+    vector<int> heap;
+    vector<int> pos; // -1 if not in the heap
+    vector<double> key;
+
+    // Constructor
+    IndexedHeap(int n=0) {
+        pos.assign(n, -1);
+        key.assign(n, 0);
+    };
+
+    bool contains(int i) { return pos[i] != -1; };
+    bool empty() { return heap.empty(); };
+    bool better(int a, int b) { return key[a] > key[b] || (key[a] == key[b] && a < b); };
+
+    void insert(int i, double k);
+    void remove(int i);
+    void update(int i, double k);
+    int top();
+    vector<int> topK(int k);
+    void siftUp(int p);
+    void siftDown(int p);
+};
+
 // Class for Partition method of SAT formula clustering
 class Partition {
 public:
@@ -219,6 +340,24 @@ public:
     // Graph
     map<int, set<int>> edges;
 
+    // Graph in CSR form (built once, read-only), neighbors of v are adj[adj_start[v]] .. adj[adj_start[v+1]-1]
+    vector<int> adj_start;
+    vector<int> adj;
+    int max_degree;
+
+    // BFS scratch space (allocated once), v is visited if visited_epoch[v] == epoch
+    vector<int> visited_epoch;
+    vector<int> bfs_depth;
+    vector<int> frontier;
+    int epoch;
+
+    // Articulation points and biconnected components (set by findArticulationPoints)
+    vector<int> articulation_points;
+    vector<vector<int>> blocks;
+    vector<vector<int>> ap_pieces; // ap_pieces[v] is the sizes of the pieces cut off from v's component by removing v
+    vector<int> component_id; // connected component of each var (1 ... vars)
+    vector<int> component_sizes;
+
 
     // Constructor
     Partition(int v, vector<vector<int>> f) {
@@ -231,19 +370,33 @@ public:
     }
     // Constructor
     Partition(map<int, set<int>> g) {
-        vars = g.size();
+        // Isolated vars aren't keys of the graph, so vars is the highest var (key or neighbor), not g.size()
+        vars = 0;
+        for(const pair<const int, set<int>>& p : g) {
+            vars = max(vars, p.first);
+            if(!p.second.empty()) vars = max(vars, *p.second.rbegin());
+        }
         edges = g;
+        debug = false;
+
+        buildCSR();
     }
 
     void createGraph();
 
-    vector<int> partitionBFS(unordered_set<int> ignore);
+    int newEpoch();
+    int bfsMark(int start, int depth);
+    vector<int> partitionBFS(const unordered_set<int>& ignore);
     vector<int> partitionBFS();
 
     unordered_set<int> neighborsBFS(int start, int depth);
     int neighborsClauseCount(int start, int depth);
 
 
+    int findArticulationPoints();
+    vector<int> sizesWithout(int ap);
+    unordered_set<int> minVertexSeparator(double balance);
+
     unordered_set<int> removeAndPartitionIDS(int start_depth, int end_depth, string heur="half");
     map<int, vector<int>> removeAndPartitionGreedy(int num_remove);
 
@@ -255,6 +408,14 @@ public:
     void swapBetweenSets(set<int>& s1, set<int>& s2, int a, int b);
     vector<set<int>> nodeKLAlg1(int d, set<int>& removed, bool shuffle_vars=false);
 
+    void buildCSR();
+    int fmBisection(vector<int>& part, int max_passes=100);
+    int fmSeparator(vector<int>& part, int max_passes=100);
+
+    // (seconds, best cost so far) after each restart of multiStartPartition finishes
+    vector<pair<double, int>> restart_curve;
+    vector<set<int>> multiStartPartition(int restarts, set<int>& removed, int d=0, int num_threads=0, unsigned seed=0, string curve_file="");
+
 
     vector<set<int>> createClausePartition(int num_partitions, bool shuffle_order);
     int clausePartitionCost(vector<set<int>> partitions);
@@ -299,15 +460,134 @@ public:
 
     void createSubarrays(int num, string heur = "round-robin");
     unordered_map<int, set<int>> checkGroupings(int mask);
+    vector<vector<int>> checkGroupingsMasks(const vector<int>& masks, int num_threads=0);
 
 };
 
 
-unordered_map<int, int> findGroupsMappingHelper(int num_clauses, bool randomize=false, int num_subarrays=1024, int num_groups=32);
+unsigned long long counterRandom(unsigned long long key, unsigned long long counter);
+vector<int> findGroupsMappingDense(int num_clauses, bool randomize=false, int num_subarrays=1024, int num_groups=32, unsigned long long seed=0, unsigned long long trial=0);
+vector<vector<int>> findGroupsMappings(int num_clauses, int trials, bool randomize=false, int num_subarrays=1024, int num_groups=32, unsigned long long seed=0, unsigned long long first_trial=0, int num_threads=0);
+unordered_map<int, int> findGroupsMappingHelper(int num_clauses, bool randomize=false, int num_subarrays=1024, int num_groups=32, long long seed=-1);
 unordered_map<int, set<int>> runGroupsExperiment(int vars, vector<vector<int>>& formula, unordered_map<int, int>& mappings);
 void printGroupsResults(unordered_map<int, set<int>> results, int num_groups);
 
 
+// Counts how many groups each var activates, for many groupings in one pass over the vars
+// Clauses have dense keys (ex: subarray numbers), and each grouping maps keys to group numbers.
+// Each var's groups are kept in a bitset and counted with popcount (or counted with stamps when
+// there are too many groups for the bitset to pay off)
+class GroupActivation {
+public:
+    int vars;
+    int num_keys;
+
+    // Clauses of var v are var_clauses[var_start[v]] .. var_clauses[var_start[v+1]-1] (0-indexed clauses)
+    vector<int> var_start;
+    vector<int> var_clauses;
+    vector<int> clause_key;
+
+    GroupActivation(int v, vector<vector<int>>& formula, const vector<int>& keys);
+
+    vector<vector<int>> countGroups(const vector<vector<int>>& key_to_group, vector<vector<int>>* per_var=nullptr, int num_threads=0);
+    vector<vector<int>> countGroupsMasks(const vector<int>& masks, vector<vector<int>>* per_var=nullptr, int num_threads=0);
+};
+
+// One subarray configuration for runGroupsExperimentBatch
+// num_groups is the number of subarrays per group (as in findGroupsMappingHelper)
+class GroupsConfig {
+public:
+    int num_subarrays;
+    int num_groups;
+    bool randomize;
+    int trials; // only used when randomize is set
+
+    // Constructor
+    GroupsConfig(int s, int g, bool r=false, int t=1) {
+        num_subarrays = s;
+        num_groups = g;
+        randomize = r;
+        trials = t;
+    };
+};
+
+vector<vector<int>> runGroupsExperimentBatch(int vars, vector<vector<int>>& formula, const vector<GroupsConfig>& configs, string csv_file="", unsigned long long seed=0, int num_threads=0);
+
+
+// Hypergraph in CSR form (used for clause partitioning: vertices are clauses, nets are vars)
+class Hypergraph {
+public:
+    int num_vertices;
+    int num_nets;
+    vector<int> vertex_weight;
+    vector<int> net_weight;
+
+    // Pins of net e are pins[net_start[e]] .. pins[net_start[e+1]-1]
+    vector<int> net_start;
+    vector<int> pins;
+    // Nets of vertex v are incident_nets[vertex_start[v]] .. incident_nets[vertex_start[v+1]-1]
+    vector<int> vertex_start;
+    vector<int> incident_nets;
+    // Var of each net (set by fromFormula)
+    vector<int> net_var;
+
+    // Constructor
+    Hypergraph() {
+        num_vertices = 0;
+        num_nets = 0;
+        net_start.push_back(0);
+    };
+
+    void fromFormula(int vars, vector<vector<int>>& formula);
+    void buildIncidence();
+    int totalWeight();
+};
+
+int hypergraphCut(Hypergraph& h, vector<int>& side);
+int hypergraphConnectivity(Hypergraph& h, vector<int>& part);
+
+// Multilevel k-way hypergraph partitioner (recursive bisection)
+// Each bisection coarsens with heavy-edge matching, bisects the coarsest hypergraph, 
+// then projects back and refines with FM on every level
+class MultilevelPartition {
+public:
+    bool debug;
+
+    double imbalance; // allowed imbalance on coarse levels (fraction of total weight)
+    int coarsen_to; // stop coarsening at this many vertices
+    int max_net_size; // nets bigger than this are ignored when matching
+    int initial_tries; // number of initial bisections to try on the coarsest level
+    mt19937 rng;
+
+    // Constructor
+    MultilevelPartition(unsigned seed=0) {
+        debug = false;
+        imbalance = 0.03;
+        coarsen_to = 100;
+        max_net_size = 1000;
+        initial_tries = 8;
+        rng.seed(seed);
+    };
+
+    vector<int> partition(Hypergraph& h, int k);
+    void recursiveBisect(Hypergraph& h, int k, int offset, vector<int>& ids, vector<int>& result);
+    vector<int> bisect(Hypergraph& h, int target0);
+
+    Hypergraph coarsen(Hypergraph& h, vector<int>& coarse_map);
+    vector<int> initialBisection(Hypergraph& h, int lo, int hi);
+    int refine(Hypergraph& h, vector<int>& side, int lo, int hi, int max_passes=8);
+    Hypergraph subHypergraph(Hypergraph& h, vector<int>& side, int s, vector<int>& sub_to_h);
+};
+
+unordered_map<int, int> findGroupsMappingMultilevel(int vars, vector<vector<int>>& formula, int num_subarrays=1024, int num_groups=32, unsigned seed=0);
+
+vector<string> listSnapshotFiles(string input_folder, string prefix="assignments", string suffix="");
+vector<double> traceVarFrequencies(string input, int vars, int& snapshots);
+vector<int> placeClausesByTrace(int vars, vector<vector<int>>& formula, const vector<double>& var_weights, int num_subarrays=1024, unsigned seed=0);
+double expectedActivations(int vars, vector<vector<int>>& formula, const vector<int>& clause_subarray, const vector<double>& var_weights, int subarrays_per_group=1);
+void runTracePlacementExperiment(int vars, vector<vector<int>>& formula, string trace_folder, int num_subarrays=1024, int num_groups=32);
+
+
 // Class for "divide and conquer" approach: satisfy k variables to create 2^k smaller problems
 class DivideFormula {
 public:
@@ -318,6 +598,8 @@ public:
     int vars_2;
     int clauses_2;
     vector<vector<int>> formula_2;
+    // If renumbered, var_map_2[new var] is the var number in formula
+    vector<int> var_map_2;
 
     unordered_set<int> assignments_made;
 
@@ -335,7 +617,7 @@ public:
 vector<unordered_set<int>> generateLitsCombos(unordered_set<int> remove_vars);
 void generateLitsCombosHelper(vector<unordered_set<int>>& answer, vector<int> remove_vars, unordered_set<int> curr, int i);
 vector<int> kMostOccurring(int vars, vector<vector<int>>& formula, int k);
-void runDivideExperiment(Circuit c, unordered_set<int> remove_vars, bool show_stats=true, bool print=false);
+void runDivideExperiment(Circuit c, unordered_set<int> remove_vars, bool show_stats=true, bool print=false, int num_threads=0);
 vector<Formula> runDivideExperimentSingleVar(Formula c, int remove_var);
 unordered_set<int> kRandomVariables(int vars, int k);
 
@@ -369,18 +651,439 @@ public:
 
 };
 
+// Assigns clauses (in order) to contiguous groups with at most max_vars unique vars each
+// Vars are stamped with their group, so starting a new group clears nothing
+class ContiguousGrouper {
+public:
+    int max_vars;
+    int curr_group;
+    int group_vars; // unique vars in the current group
+    int clause_count; // clauses added so far
+    bool group_full; // current group holds a clause with more than max_vars vars
+
+    vector<int> group_stamp; // group_stamp[v] is (last group v was in) + 1
+    vector<int> clause_stamp; // clause_stamp[v] is the last clause v was in (1-indexed)
+    vector<int> var_groups; // var_groups[v] is the number of groups v is in
+
+    // Constructor (arrays grow if a var bigger than v shows up)
+    ContiguousGrouper(int v, int m) {
+        max_vars = m;
+        curr_group = 0;
+        group_vars = 0;
+        clause_count = 0;
+        group_full = false;
+        group_stamp.assign(v+1, 0);
+        clause_stamp.assign(v+1, 0);
+        var_groups.assign(v+1, 0);
+    };
+
+    int addClause(const vector<int>& clause);
+    int numGroups();
+};
+
+int streamContiguousPartition(const string& cnf_file, int max_vars, const string& output_file, vector<int>& histogram, bool print=false);
+
 void findVarMeanAndSDClause(int var, vector<vector<int>>& formula);
 void findAllMeanAndSdClauses(int total_vars, vector<vector<int>>& formula);
 
+int formulaMaxVar(const vector<vector<int>>& formula, int vars=0);
+vector<double> jwWeights(int max_size);
 int heurFindJeroslowWang(vector<vector<int>>& formula, int vars);
 int heurFindMostOccurLit(vector<vector<int>>& formula, int vars);
 int heurFindMostOccurVar(vector<vector<int>>& formula, int vars);
 int heurFindMOM(vector<vector<int>>& formula, int vars);
+
+// A leaf of the divide and conquer split tree
+class Cube {
+public:
+    vector<int> lits; // decisions, in order (pass as assumptions to a solver)
+    int vars_remaining;
+    int clauses_remaining;
+    bool solved; // every clause is satisfied
+};
+
+// Splits a formula into cubes without copying it: assignments are kept on a trail with 
+// watched literal propagation, the split tree is explored depth first, and each level is undone
+// Remaining vars and clauses are kept as counters (satisfied literals per clause, unsatisfied occurrences per var)
+class CubeGenerator {
+public:
+    int vars;
+    int clauses;
+    vector<vector<int>>& formula;
+    bool debug;
+
+    // Clauses of literal l are occ[occ_start[litIndex(l)]] .. occ[occ_start[litIndex(l)+1]-1]
+    vector<int> occ_start;
+    vector<int> occ;
+    // watches[litIndex(l)] is the clauses watching l, the watched positions of clause c are watch_pos[2c], watch_pos[2c+1]
+    vector<vector<int>> watches;
+    vector<int> watch_pos;
+
+    vector<int> value; // value[v] is 1, -1, or 0 (unassigned)
+    vector<int> trail;
+    vector<int> trail_lim; // trail size when each level was opened
+    vector<int> decisions;
+    int qhead;
+    bool root_conflict;
+
+    vector<int> sat_count; // true literals in each clause
+    vector<int> active; // occurrences of each var in unsatisfied clauses
+    int vars_remaining; // unassigned vars in unsatisfied clauses
+    int clauses_remaining;
+
+    vector<Cube> cubes;
+    int failed; // branches ending in a conflict
+
+    // Heuristic scores of the reduced formula (see trackScores), litIndex() numbering
+    int score_mode; // -1 = not tracked, 0 = most occurring var, 1 = most occurring lit, 2 = jeroslow-wang, 3 = mom
+    vector<int> free_count; // unassigned literals in each clause
+    vector<int> size_count; // size_count[s] is the number of unsatisfied clauses with s unassigned literals
+    vector<int> occ_score; // occurrences in unsatisfied clauses
+    vector<double> jw_score;
+    vector<double> jw_weight; // jw_weight[s] = 2^-s
+    vector<vector<int>> mom_count; // mom_count[s][l] is occurrences in unsatisfied clauses of size s (s <= mom_max_size)
+    int mom_max_size;
+    int mom_size; // clause size the MOM heap keys use
+    IndexedHeap score_heap;
+    vector<int> touched;
+    vector<int> touch_stamp;
+    int stamp;
+    int lookahead_candidates; // vars tried by pickVarLookahead
+
+    CubeGenerator(int v, vector<vector<int>>& f);
+
+    int litIndex(int lit) { return 2*abs(lit) + (lit < 0); };
+    int litValue(int lit) { return lit > 0 ? value[lit] : -value[-lit]; };
+
+    void assign(int lit);
+    void unassign(int lit);
+    bool propagate();
+    bool assume(int lit);
+    void undo();
+    int pickVar(string heur);
+    int pickVarScan(string heur);
+    vector<Cube> generate(int k, string heur, bool print=false, bool scan=false);
+    void split(int k, string heur, bool print);
+    void enumerateSplits(const vector<int>& split_vars, int fixed, long long prefix, const function<void(const vector<int>&, bool)>& visit);
+
+    void trackScores(string heur);
+    void updateScores(int c, int sign);
+    void removeTouchedScores(int var);
+    void addTouchedScores(int var, int delta);
+    double scoreKey(int item);
+    void buildScoreHeap();
+    int minClauseSize();
+    vector<int> topVars(int k);
+    int pickVarLookahead();
+};
+
 void divideAndConquerHeur(Circuit c, int k, string heur, bool print=false);
 
+// Propagation core of the legacy solve(): dense assignment, two watched literals per clause, a trail with
+// decision level markers, and a reason clause per var. Search is the same as before (on a conflict, the last
+// decision is flipped, and with cdcl the clause of decisions behind the conflict is learned), with the same heuristic strings
+class WatchedSolver {
+public:
+    int vars;
+    string heuristic;
+    bool cdcl;
+    bool print;
+
+    vector<vector<int>> clauses; // original and learned clauses (watched literals are the first two)
+    vector<vector<int>> watches; // watches[litIndex(l)]: clauses watching l
+    vector<signed char> value; // value[v]: 1 (true), -1 (false), 0 (unassigned)
+    vector<int> reason; // reason[v]: clause that implied v (-1 for decisions, flips, and assumptions)
+    vector<int> level; // level[v]: decision level v was assigned at
+    vector<int> trail;
+    vector<int> trail_lim; // trail_lim[i]: trail position of the decision of level i+1
+    int qhead;
+    vector<int> occurrences; // occurrences[v]: literals of v over all clauses (for "max appearances")
+    vector<int> seen; // stamps for analyze()
+    int stamp;
+    bool root_conflict;
+
+    // Learned clauses in order (cdcl), and the learned units: those aren't watched, so they're
+    // asserted again (like the legacy unit deduction) after every backtrack
+    vector<vector<int>> learned;
+    vector<int> learned_units;
+    bool units_pending;
+
+    long long decisions;
+    long long propagations; // assignments implied by a clause
+    long long conflicts;
+    long long root_units; // unit clauses of the formula, assigned by the constructor
+
+    WatchedSolver(int v, vector<vector<int>>& formula, string heur="order", bool learn=false, bool p=false);
+
+    int litIndex(int lit) { return 2*abs(lit) + (lit < 0); }
+    int litValue(int lit) { return lit > 0 ? value[lit] : -value[-lit]; }
+    int decisionLevel() { return trail_lim.size(); }
+
+    int addClause(vector<int> c);
+    void assign(int lit, int from);
+    int assertLearnedUnits();
+    int propagate();
+    void backtrack(int lvl);
+    vector<int> analyze(int conflict);
+    int survey(int v);
+    int pickDecision();
+    bool solve(const unordered_set<int>& assumptions=unordered_set<int>());
+};
+
+// Solves cubes with a pool of minisat solvers (one per worker, reused across that worker's cubes)
+class CubeSolver {
+public:
+    int vars;
+    vector<vector<int>>& formula;
+    bool debug;
+
+    // For each cube: time, result (1 = SAT, 0 = UNSAT, -1 = not solved), and worker that solved it
+    vector<double> cube_seconds;
+    vector<int> cube_results;
+    vector<int> cube_worker;
+    double wall_seconds;
+    double baseline_seconds; // -1 until solveBaseline() is run
+
+    // Constructor
+    CubeSolver(int v, vector<vector<int>>& f) : formula(f) {
+        vars = v;
+        debug = false;
+        wall_seconds = 0;
+        baseline_seconds = -1;
+    };
+
+    bool solveCubes(const vector<Cube>& cubes, vector<int>& model, int num_threads=0);
+    bool solveBaseline(vector<int>& model);
+    void printStats();
+};
+
+// Finds the backbone of a formula (literals that are true in every model) with one incremental minisat solver:
+// after a first model, each remaining candidate is tested by assuming its negation, and every new model
+// drops the candidates it disagrees with. Backbone vars can be removed before mapping or splitting
+class BackboneExtractor {
+public:
+    int vars;
+    vector<vector<int>>& formula;
+    bool debug;
+
+    vector<int> backbone; // backbone literals, by var
+    int solves; // solver calls (including the first solve)
+    int filtered; // candidates dropped by a model, without their own call
+    int unknown; // candidates whose call ran out of conflict budget (left out of the backbone)
+    double seconds;
+
+    // Constructor
+    BackboneExtractor(int v, vector<vector<int>>& f) : formula(f) {
+        vars = v;
+        debug = false;
+        solves = 0;
+        filtered = 0;
+        unknown = 0;
+        seconds = 0;
+    };
+
+    bool extract(long long conflict_budget=-1);
+    vector<vector<int>> simplifiedFormula();
+    void printStats();
+};
+
 vector<int> calculateHeurList(string heur, vector<vector<int>>& formula, int vars);
 unordered_set<int> parseAssignmentsFile(string filename, int& propagations);
 vector<vector<int>> assign(vector<vector<int>>& formula, unordered_set<int> assignments);
 vector<int> parseHeurListFile(string filename, int& propagations);
 int compareHeurLists(const vector<int> l1, const vector<int> l2, string metric="index diff");
 
+// Reads the binary snapshot log written by the modified minisat (-snapshot-log, format in its Solver.h)
+// The file is mmapped, and each trail is rebuilt from the previous one, so stepping through the
+// log only touches the literals that changed between snapshots
+class SnapshotLog {
+public:
+    int fd;
+    const char* data;
+    size_t size;
+
+    int vars;
+    int keyframe_every;
+    vector<int64_t> offsets; // byte offset of each record (from the index, or found by scanning the records)
+
+    // Current snapshot (-1 before the first next())
+    int current;
+    long long propagations;
+    vector<int> trail; // literals of the current snapshot, in trail order
+
+    SnapshotLog(const string& filename);
+    ~SnapshotLog();
+
+    // Owns the fd and the mapping
+    SnapshotLog(const SnapshotLog&) = delete;
+    SnapshotLog& operator=(const SnapshotLog&) = delete;
+
+    bool isOpen() const { return data != nullptr; }
+    int numSnapshots() const { return offsets.size(); }
+    int recordKeep(int i) const;
+    bool applyRecord(int i);
+    bool next();
+    bool seek(int i);
+};
+
+bool isSnapshotLog(string input);
+int writeSnapshotLog(string input_folder, string log_file, int vars, int keyframe_every=256);
+
+// Streams the snapshots of a solver trace and measures how far the "occurrences" heuristic list drifts from 
+// the original formula's list. Occurrences in unsatisfied clauses are updated per changed literal, so no 
+// simplified formula is ever built
+class HeurListDrift {
+public:
+    int vars;
+    vector<vector<int>>& formula;
+    int top_k;
+
+    vector<int> occ_start;
+    vector<int> occ;
+    vector<int> sat_count; // true literals in each clause
+    vector<int> var_occ; // occurrences of each var in unsatisfied clauses
+    vector<signed char> value;
+    vector<int> assigned; // literals of the current snapshot
+
+    vector<int> original_list;
+    vector<int> original_rank; // original_rank[v] is the index of v in original_list
+
+    HeurListDrift(int v, vector<vector<int>>& f, int k=100);
+
+    void setLiteral(int lit, int sign);
+    void setAssignments(const vector<int>& lits);
+    vector<int> currentList();
+    double kendallTau(const vector<int>& list);
+    double topKOverlap(const vector<int>& list);
+    int run(string input, string csv_file);
+};
+
+
+vector<int> findAllSpans(int vars, vector<vector<int>>& formula, bool circular=true);
+void printSpanStats(string label, int vars, vector<vector<int>>& formula, bool circular=true);
+
+// Class for reordering clauses and variables so each variable's clauses are close together
+// (smaller spans make folding and row placement easier)
+class ReorderFormula {
+public:
+    bool debug;
+
+    int vars;
+    int clauses;
+    vector<vector<int>> formula;
+
+    // Variable to clause index (CSR): clauses of var v are var_clause_list[var_start[v] ... var_start[v+1]-1]
+    vector<int> var_start;
+    vector<int> var_clause_list;
+
+    // Results of reorder()
+    vector<vector<int>> reordered_formula;
+    vector<int> clause_order;   // clause_order[i] is the original clause (0-indexed) on row i
+    vector<int> old_to_new_var; // old_to_new_var[old var] is the new var
+    vector<int> new_to_old_var; // new_to_old_var[new var] is the old var
+
+    // Constructor
+    ReorderFormula(int v, vector<vector<int>> f) {
+        vars = v;
+        formula = f;
+        clauses = f.size();
+        debug = false;
+
+        buildIndex();
+    };
+
+    void buildIndex();
+
+    void cuthillMcKeeBFS(int start, vector<char>& visited, vector<char>& expanded, vector<int>& degree, vector<int>& order);
+    vector<int> cuthillMcKeeOrder(bool reverse_order=true);
+    vector<int> positionsToOrder(const vector<double>& pos);
+    vector<int> spectralOrder(int iterations=200);
+    vector<int> forceOrder(int iterations=20);
+    long long orderTotalSpan(const vector<int>& order);
+
+    void applyOrder(const vector<int>& order);
+    bool reorder(string heur="reverse-cuthill-mckee");
+    void writeReordered(const string& outputFilename, const string& description="");
+};
+
+int threadsToUse(int num_threads);
+void parallelFor(int n, int num_threads, const function<void(int)>& func);
+
+// Class for splitting a formula into independent (connected) components, which can be mapped and solved separately
+class ComponentDecomposition {
+public:
+    bool debug;
+
+    int vars;
+    int clauses;
+    vector<vector<int>> formula;
+
+    // Literals assigned by simplify() before decomposing (if remove_units)
+    unordered_set<int> unit_assignment;
+
+    // Result of the last decompose() (-1 if UNSAT, -2 before decompose() is called)
+    int num_components;
+    // components[i] is renumbered so its vars are 1..components[i].vars
+    vector<Formula> components;
+    // component_vars[i][new var] is the var in formula
+    vector<vector<int>> component_vars;
+
+    // Constructor
+    ComponentDecomposition(int v, vector<vector<int>> f) {
+        vars = v;
+        formula = f;
+        clauses = f.size();
+        debug = false;
+        num_components = -2;
+    };
+
+    int findRoot(vector<int>& parent, int v);
+    int decompose(bool remove_units=false);
+    void printComponents();
+
+    bool solveComponents(vector<int>& model, string heuristic="order", bool cdcl=true, int num_threads=0);
+    int mapComponents(double fold_fraction=0.5, string method="default", bool descending=false, int num_threads=0);
+};
+
+void evaluateRandomAssignments(int vars, vector<vector<int>>& formula, long long n, long long& total_unsatisfied, long long& solutions, bool count_unsatisfied=true, unsigned long long seed=0, int num_threads=0);
+void unsatisfiedAndSolutionsMetricBits(int vars, vector<vector<int>>& formula, long long n, double& unsatisfiedAvg, double& solutionsPercent, unsigned long long seed=0, int num_threads=0);
+float solutionsMetricBits(int vars, vector<vector<int>>& formula, long long n, unsigned long long seed=0, int num_threads=0);
+
+// Occurrence, balance and span statistics of every var, computed in one pass over the clauses (split into
+// chunks that run in parallel and are merged afterwards), plus the summary metrics from old_funcs
+// (unipolarityMetric, maxOccurrencesMetric, medianSpanMetric, maxBalanceMetric, ...)
+// Vars that never appear have span -1, which counts in the span average and median as in old_funcs (see summarize())
+class FormulaMetrics {
+public:
+    int vars;
+    int clauses;
+    long long literals;
+
+    // Per var (index = var)
+    vector<int> positive; // occurrences as a positive literal
+    vector<int> negative; // occurrences as a negative literal (balance = positive - negative)
+    vector<int> spans; // circular spans (same as findSpan())
+
+    // Summary (see summarize() for the denominators)
+    int appearing;
+    int unipolar;
+    int max_occurrences;
+    double avg_occurrences;
+    double sd_occurrences;
+    double median_occurrences;
+    int max_span;
+    double avg_span;
+    double median_span;
+    int max_balance;
+    int min_balance;
+    double avg_balance;
+    double median_balance;
+
+    FormulaMetrics(int v, vector<vector<int>>& formula, int num_threads=0);
+
+    void summarize();
+    static string csvHeader();
+    string csvRow() const;
+};
+
+int runFormulaMetrics(string input_folder, string csv_file, int num_threads=0);
@@ -141,6 +141,8 @@ int main(int argc, char** argv)
             fclose(res);
         }
         
+        S.closeSnapshotLog();
+
 #ifdef NDEBUG
         exit(ret == l_True ? 10 : ret == l_False ? 20 : 0);     // (faster than "return", which will invoke the destructor for 'Solver')
 #else
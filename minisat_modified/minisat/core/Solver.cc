@@ -25,6 +25,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include <unordered_map>
 #include <queue>
 #include <cstdlib>
+#include <cstdio>
 
 #include "minisat/mtl/Alg.h"
 #include "minisat/mtl/Sort.h"
@@ -57,6 +58,8 @@ static IntOption     opt_min_learnts_lim   (_cat, "min-learnts", "Minimum learnt
 static StringOption  opt_custom_heuristic  ("activity", "custom-heuristic",   "Heuristic to use [activity (default), dynamic_var_occurrences, dynamic_jeroslow_wang, dynamic_mom, random]");
 static IntOption     opt_duration_threshold_seconds     (_cat, "duration-threshold-seconds", "Duration threshold in seconds (if nonpositive, ignored)",  -1,  IntRange(-100, INT32_MAX));
 static IntOption     opt_max_iterations    (_cat, "max-iterations", "If set > 0, terminates program after max_iterations", -1, IntRange(-100, INT32_MAX));
+static StringOption  opt_snapshot_log      (_cat, "snapshot-log", "Binary file to append trail snapshots to (delta-encoded, see Solver.h)");
+static IntOption     opt_snapshot_every    (_cat, "snapshot-every", "Propagations between trail snapshots in the snapshot log", 1000, IntRange(1, INT32_MAX));
 
 
 //=================================================================================================
@@ -135,11 +138,25 @@ Solver::Solver() :
     // Ex: for random_var_freq = 0.2, this would result in 50
     activate_rand_branch_every = static_cast<int>(1.0 / random_var_freq);
     pick_branch_lit_counter = 0;
+
+    // Snapshot log (opened on the first snapshot, once the variables are known)
+    snapshot_file = NULL;
+    snapshot_every = 0;
+    if (opt_snapshot_log) {
+        snapshot_path = std::string((const char*)opt_snapshot_log);
+        snapshot_every = opt_snapshot_every;
+    }
+    snapshot_goal = snapshot_every;
+    snapshot_keep = 0;
+    snapshot_size = 0;
+    snapshot_bytes = 0;
 }
 
 
 Solver::~Solver()
-{}
+{
+    closeSnapshotLog();
+}
 
 
 //=================================================================================================
@@ -267,6 +284,9 @@ bool Solver::satisfied(const Clause& c) const {
 //
 void Solver::cancelUntil(int level) {
     if (decisionLevel() > level){
+        if (trail_lim[level] < snapshot_keep)
+            snapshot_keep = trail_lim[level];
+
         // std::cout << "backtrack from level " << decisionLevel() << " to " << level << " (" << (decisionLevel() - level) << " levels)\n";
         // backtrack_levels.push_back(decisionLevel() - level);
         // int sum = 0;
@@ -938,6 +958,9 @@ lbool Solver::search(int nof_conflicts)
         // printf("\n\n");
         // prop_goal += k;
 
+        if (snapshot_every > 0 && propagations >= snapshot_goal)
+            writeSnapshot();
+
         // // Calculate heap size
         iterations++;
         // total_heap_size += order_heap.size();
@@ -966,6 +989,7 @@ lbool Solver::search(int nof_conflicts)
             printStats();
             std::cout << "\nEXITED FROM EXCEEDING TIME LIMIT...\n";
             std::cout << "\tDuration of " << duration_threshold_seconds << " seconds exceeded (" << elapsed_seconds.count() << "s elapsed)\n";
+            closeSnapshotLog();
             exit(0);
         }
 
@@ -973,6 +997,7 @@ lbool Solver::search(int nof_conflicts)
         if (max_iterations > 0 && iterations > max_iterations) {
             printStats();
             std::cout << "\nEXITED FROM EXCEEDING ITERATION LIMIT OF " << max_iterations << "...\n";
+            closeSnapshotLog();
             exit(0);
         }
 
@@ -1291,6 +1316,79 @@ void Solver::toDimacs(FILE* f, const vec<Lit>& assumps)
 }
 
 
+//=================================================================================================
+// Snapshot log:
+
+
+void Solver::writeSnapshot()
+{
+    snapshot_goal = propagations + snapshot_every;
+
+    if (snapshot_file == NULL){
+        snapshot_file = fopen(snapshot_path.c_str(), "wb");
+        if (snapshot_file == NULL){
+            fprintf(stderr, "ERROR! Could not open snapshot log: %s\n", snapshot_path.c_str());
+            snapshot_every = 0;
+            return; }
+        setvbuf(snapshot_file, NULL, _IOFBF, 1 << 20);
+
+        int32_t header[2] = { nVars(), snapshot_keyframe_every };
+        if (fwrite("SATSNAP1", 1, 8, snapshot_file) != 8 ||
+            fwrite(header, sizeof(int32_t), 2, snapshot_file) != 2){
+            failSnapshotLog();
+            return; }
+        snapshot_bytes = 8 + sizeof(header);
+        snapshot_keep = snapshot_size = 0;
+    }
+
+    // Only the literals past the prefix shared with the previous snapshot are written
+    int keep = snapshot_keep < snapshot_size ? snapshot_keep : snapshot_size;
+    if (snapshot_offsets.size() % snapshot_keyframe_every == 0)
+        keep = 0;
+
+    snapshot_buf.clear();
+    for (int i = keep; i < trail.size(); i++)
+        snapshot_buf.push_back(sign(trail[i]) ? -(var(trail[i]) + 1) : var(trail[i]) + 1);
+
+    int64_t props    = propagations;
+    int32_t header[2] = { keep, (int32_t)snapshot_buf.size() };
+    if (fwrite(&props, sizeof(props), 1, snapshot_file) != 1 ||
+        fwrite(header, sizeof(int32_t), 2, snapshot_file) != 2 ||
+        fwrite(snapshot_buf.data(), sizeof(int32_t), snapshot_buf.size(), snapshot_file) != snapshot_buf.size()){
+        failSnapshotLog();
+        return; }
+
+    snapshot_offsets.push_back(snapshot_bytes);
+    snapshot_bytes += sizeof(props) + sizeof(header) + sizeof(int32_t) * snapshot_buf.size();
+    snapshot_keep = snapshot_size = trail.size();
+}
+
+
+void Solver::closeSnapshotLog()
+{
+    if (snapshot_file == NULL) return;
+
+    int64_t n = snapshot_offsets.size();
+    bool ok = fwrite(snapshot_offsets.data(), sizeof(int64_t), snapshot_offsets.size(), snapshot_file) == snapshot_offsets.size()
+           && fwrite(&n, sizeof(n), 1, snapshot_file) == 1
+           && fwrite("SNAPIDX1", 1, 8, snapshot_file) == 8;
+    if (fclose(snapshot_file) != 0) ok = false;
+    snapshot_file = NULL;
+    if (!ok)
+        fprintf(stderr, "ERROR! Could not write snapshot log: %s\n", snapshot_path.c_str());
+}
+
+
+void Solver::failSnapshotLog()
+{
+    // The log is left without an index (SnapshotLog finds the complete records by scanning)
+    fprintf(stderr, "ERROR! Could not write snapshot log: %s (logging stopped)\n", snapshot_path.c_str());
+    fclose(snapshot_file);
+    snapshot_file = NULL;
+    snapshot_every = 0;
+}
+
+
 void Solver::printStats() const
 {
     double cpu_time = cpuTime();
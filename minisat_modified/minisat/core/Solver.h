@@ -279,6 +279,27 @@ public:
 
     bool verification_logs = true;
 
+    // Binary snapshot log (-snapshot-log): every snapshot_every propagations, search() appends the trail
+    // delta-encoded against the previous snapshot (read by SnapshotLog in funcs.hpp)
+    //   header: "SATSNAP1", int32 vars, int32 keyframe_every
+    //   record: int64 propagations, int32 keep, int32 count, int32 lits[count] (DIMACS literals)
+    //           trail = first keep lits of the previous snapshot + lits (keep is 0 on keyframes)
+    //   index:  int64 offsets[n], int64 n, "SNAPIDX1" (appended by closeSnapshotLog)
+    std::string          snapshot_path;
+    FILE*                snapshot_file;
+    int                  snapshot_every;
+    uint64_t             snapshot_goal;
+    int                  snapshot_keep;     // trail prefix left untouched since the last snapshot
+    int                  snapshot_size;     // trail size at the last snapshot
+    int64_t              snapshot_bytes;
+    std::vector<int64_t> snapshot_offsets;
+    std::vector<int32_t> snapshot_buf;
+    static const int     snapshot_keyframe_every = 256;
+
+    void     writeSnapshot    ();                                                      // Append the current trail to the snapshot log.
+    void     closeSnapshotLog ();                                                      // Write the index and close the snapshot log.
+    void     failSnapshotLog  ();                                                      // Report a write error and stop logging.
+
     // Main internal methods:
     //
     void     insertVarOrder   (Var x);                                                 // Insert a variable in the decision order priority queue.
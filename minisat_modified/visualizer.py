@@ -119,6 +119,31 @@ def plot_sim_runtime_scatter(df, font_path="TimesNewRoman.ttf"):
 
 
 
+# include group histograms df (written by runGroupsExperimentBatch, index_col=0 is the config name)
+def plot_group_histograms(df, font_path="TimesNewRoman.ttf"):
+    font_prop = FontProperties(fname=font_path, size=20)
+    font_prop_small = FontProperties(fname=font_path, size=16)
+
+    plt.figure(figsize=(12, 6))
+    for config, config_df in df.groupby(level=0):
+        # Average randomized trials
+        trials = config_df['trial'].nunique()
+        counts = config_df.groupby('groups_activated')['num_vars'].sum() / trials
+        plt.plot(counts.index, counts.values, marker='o', markersize=3, label=config)
+
+    plt.xlabel('Groups Activated', fontproperties=font_prop)
+    plt.ylabel('Number of Variables', fontproperties=font_prop)
+    plt.yticks(fontproperties=font_prop_small)
+    plt.xticks(fontproperties=font_prop_small)
+    plt.legend(prop=font_prop_small)
+    plt.grid(True, linestyle='--', alpha=0.6)
+    plt.tight_layout()
+
+    filepath = os.path.join(OUTPUT_DIRECTORY, 'group_histograms.png')
+    plt.savefig(filepath)
+
+
+
 def main():
     matplotlib_fonts()
 
@@ -147,6 +172,9 @@ def main():
     plot_sim_runtime_comparison(results_df)
     plot_sim_runtime_scatter(results_df)
 
+    # groups_df = pd.read_csv(os.path.join(OUTPUT_DIRECTORY, 'group_histograms.csv'), index_col=0)
+    # plot_group_histograms(groups_df)
+
 
 if __name__ == '__main__':
     main()
\ No newline at end of file
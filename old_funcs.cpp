@@ -313,9 +313,12 @@ int survey(vector<vector<int>>& formula, unordered_set<int>& s, int v) {
 }
 
 
-// Solve the formula
+// Defined in funcs.cpp (runs on WatchedSolver)
+bool solve(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter);
+
+// Original version of solve() (full formula scans over unordered_set assignments), kept to compare against
 // Possible heuristics for decisions: order, random, random survey, max survey, max appearances, jeroslow-wang, mom
-bool solve(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter) {
+bool solveOld(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter) {
     vector<int> stack, decisions;
     queue<int> units;
     unordered_map<int, int> antecedents;
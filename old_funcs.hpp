@@ -31,6 +31,7 @@ void printTime(clock_t start, clock_t end);
 
 int survey(vector<vector<int>>& formula, unordered_set<int>& s, int v);
 bool solve(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter);
+bool solveOld(vector<vector<int>>& formula, unordered_set<int>& s, int vars, string heuristic, bool cdcl, bool print, int& counter);
 
 int clauseShout(vector<int>& clause, unordered_set<int>& s);
 bool solveCircuit(vector<vector<int>>& formula, unordered_set<int>& s, int vars, int heuristic = 0, bool print = false);
@@ -0,0 +1,110 @@
+// Regression tests for the watched-literal solve(). Usage: "make test"
+// (built with -D_GLIBCXX_ASSERTIONS so out-of-bounds clause accesses abort)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <list>
+#include <algorithm>
+#include <cstdlib>
+#include "../old_funcs.hpp"
+#include "../funcs.hpp"
+
+using namespace std;
+
+/**
+ * Checks that an assignment satisfies every clause of a formula
+ * 
+ * Returns:
+ * - bool: true iff every clause has a literal in s
+*/
+bool satisfies(const vector<vector<int>>& formula, const unordered_set<int>& s) {
+    for(const vector<int>& c : formula) {
+        bool sat = false;
+        for(int l : c) if(s.count(l)) sat = true;
+        if(!sat) return false;
+    }
+    return true;
+}
+
+/**
+ * Builds a random 3-SAT formula (distinct vars in each clause)
+ * 
+ * Params:
+ * - int vars: number of vars
+ * - int clauses: number of clauses
+ * 
+ * Returns:
+ * - vector<vector<int>>: the formula
+*/
+vector<vector<int>> randomFormula(int vars, int clauses) {
+    vector<vector<int>> formula;
+    for(int i = 0; i < clauses; ++i) {
+        vector<int> c;
+        while(c.size() < 3) {
+            int v = rand() % vars + 1;
+            bool repeated = false;
+            for(int l : c) if(abs(l) == v) repeated = true;
+            if(!repeated) c.push_back(rand() % 2 ? v : -v);
+        }
+        formula.push_back(c);
+    }
+    return formula;
+}
+
+int main() {
+    int failures = 0;
+
+    // Learns the unit clause (2) above the root, which used to be watched and read past its end
+    vector<vector<int>> formula = {{-2,3},{-3,5},{-3,-5},{-1,2,4},{-1,2,-4},{2,6,7}};
+    for(bool cdcl : {false, true}) {
+        vector<vector<int>> f = formula;
+        unordered_set<int> s;
+        int n = 0;
+        bool sat = solve(f, s, 7, "order", cdcl, false, n);
+        if(!sat || !satisfies(formula, s)) {
+            cout << "FAIL: learned unit clause (cdcl=" << cdcl << ")" << endl;
+            failures++;
+        }
+    }
+
+    // Unsatisfiable, and with cdcl only refuted through learned units
+    vector<vector<int>> unsat = {{1,2},{1,-2},{-1,3},{-1,-3}};
+    for(bool cdcl : {false, true}) {
+        vector<vector<int>> f = unsat;
+        unordered_set<int> s;
+        int n = 0;
+        if(solve(f, s, 3, "order", cdcl, false, n)) {
+            cout << "FAIL: unsatisfiable formula (cdcl=" << cdcl << ")" << endl;
+            failures++;
+        }
+    }
+
+    // Same answer as solveOld for every heuristic, on small random formulas around the threshold
+    vector<string> heuristics = {"order", "random", "random survey", "max survey", "max appearances",
+        "max appearances updated", "jeroslow-wang", "mom"};
+    for(int seed = 1; seed <= 20; ++seed) {
+        srand(seed);
+        int vars = 8 + seed % 8;
+        vector<vector<int>> random = randomFormula(vars, vars * 4 + seed % 5 * 2);
+        for(const string& heuristic : heuristics) {
+            for(bool cdcl : {false, true}) {
+                vector<vector<int>> f = random, g = random;
+                unordered_set<int> s, t;
+                int n = 0, m = 0;
+                bool sat = solve(f, s, vars, heuristic, cdcl, false, n);
+                bool expected = solveOld(g, t, vars, heuristic, cdcl, false, m);
+                if(sat != expected || (sat && !satisfies(random, s))) {
+                    cout << "FAIL: seed " << seed << ", " << heuristic << " (cdcl=" << cdcl << ")" << endl;
+                    failures++;
+                }
+            }
+        }
+    }
+
+    cout << (failures ? "FAILED" : "OK") << endl;
+    return failures ? 1 : 0;
+}